@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <iostream>
+#include "jsonarrayreader.h"
+
+using namespace std;
+
+// reads all elements, 'chunk' = 0 reads the text without copying
+static JsonArrayReader::Status readAll(const string &text, size_t chunk, string &elements, size_t &offset)
+{
+    JsonArrayReader external(text.data(), text.size());
+    JsonArrayReader fed;
+    JsonArrayReader &reader = chunk == 0 ? external : fed;
+
+    JsonObject element;
+    size_t pos = 0;
+    elements.clear();
+
+    while (true) {
+        JsonArrayReader::Status status = reader.next(element);
+        if (status == JsonArrayReader::READ_ELEMENT) {
+            elements += element.stringify(JsonObject::MODE_COMPACT) + ";";
+        }
+        else if (status == JsonArrayReader::READ_NEED_MORE) {
+            if (pos == text.size()) {
+                reader.finish();
+                continue;
+            }
+
+            size_t size = std::min(chunk, text.size() - pos);
+            reader.feed(text.data() + pos, size);
+            pos += size;
+        }
+        else {
+            offset = reader.errorOffset();
+            return status;
+        }
+    }
+}
+
+static bool check(const string &text, JsonArrayReader::Status expected, const string &elements, size_t offset = 0)
+{
+    bool success = true;
+
+    for (size_t chunk : {0, 1, 3, 1024}) {
+        string result;
+        size_t errorOffset = 0;
+        JsonArrayReader::Status status = readAll(text, chunk, result, errorOffset);
+
+        if (status != expected || result != elements ||
+            (status == JsonArrayReader::READ_ERROR && errorOffset != offset)) {
+            cerr << "reading '" << text << "' by " << chunk << " returned " << status
+                 << " at " << errorOffset << " with elements " << result << endl;
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+int main()
+{
+    bool success = true;
+
+    success &= check("[]", JsonArrayReader::READ_END, "");
+    success &= check(" [ 1 , {\"a\": [2, \"]\"]},\n \"x\\\"],\" ] \r\n\t", JsonArrayReader::READ_END,
+                     "1;{\"a\":[2,\"]\"]};\"x\\\"],\";");
+
+    // text after the closing bracket
+    success &= check("[1,2] junk", JsonArrayReader::READ_ERROR, "1;2;", 6);
+    success &= check("[1,2]]", JsonArrayReader::READ_ERROR, "1;2;", 5);
+    success &= check("[1] [2]", JsonArrayReader::READ_ERROR, "1;", 4);
+
+    // malformed and truncated arrays
+    success &= check("{}", JsonArrayReader::READ_ERROR, "", 0);
+    success &= check("[1,]", JsonArrayReader::READ_ERROR, "1;", 3);
+    success &= check("[,1]", JsonArrayReader::READ_ERROR, "", 1);
+    success &= check("[1 2]", JsonArrayReader::READ_ERROR, "", 3);
+    success &= check("[1,2", JsonArrayReader::READ_ERROR, "1;", 4);
+    success &= check("[\"a\\\"]", JsonArrayReader::READ_ERROR, "", 6);
+
+    if (!success)
+        return 1;
+
+    cout << "JsonArrayReader: all arrays checked" << endl;
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include "jsonobject.h"
+#include "jsonformatter.h"
+
+using namespace std;
+
+static string loadTestRecords(size_t count)
+{
+    string data = "[]";
+
+#ifdef TEST_JSON_PATH
+    std::ifstream jsonFile(TEST_JSON_PATH);
+    if(jsonFile) {
+        ostringstream ss;
+        ss << jsonFile.rdbuf();
+        data = ss.str();
+    }
+#endif
+
+    // repeat content of the test array 'count' times
+    size_t begin = data.find('['), end = data.rfind(']');
+    string records = data.substr(begin + 1, end - begin - 1);
+
+    string result = "[";
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) result += ",";
+        result += records;
+    }
+    result += "]";
+    return result;
+}
+
+template<typename Func>
+static double measure(size_t repeats, Func func)
+{
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < repeats; ++i)
+        func();
+
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / repeats;
+}
+
+int main()
+{
+    string text = loadTestRecords(5000);
+    cout << "Document size: " << text.size() / 1024 << " KB" << endl;
+
+    { // Small edit of a big document: whole text vs JSON Patch
+        JsonObject source;
+        source.parse(text);
+
+        JsonObject edited = source;
+        JsonObject patch;
+        patch.parse(string("[{\"op\":\"replace\",\"path\":\"/1234/age\",\"value\":42}]"));
+        edited.applyPatch(patch);
+
+        double fullMs = measure(5, [&]() {
+            JsonObject received;
+            received.parse(edited.stringify(JsonObject::MODE_COMPACT));
+        });
+
+        double diffMs = measure(5, [&]() {
+            JsonObject::diff(source, edited).stringify(JsonObject::MODE_COMPACT);
+        });
+
+        // apply the edit and its inverse to the same object
+        JsonObject revert = JsonObject::diff(edited, source);
+        JsonObject received = source;
+        double applyMs = measure(100, [&]() {
+            received.applyPatch(patch);
+            received.applyPatch(revert);
+        }) / 2;
+
+        JsonObject copy = source;
+        double sameMs = measure(5, [&]() { JsonObject::diff(source, source); });
+        double equalMs = measure(5, [&]() { JsonObject::diff(source, copy); });
+
+        cout << "Stringify + parse whole document: " << fullMs << " ms" << endl;
+        cout << "Diff of small edit: " << diffMs << " ms" << endl;
+        cout << "Apply patch in place: " << applyMs << " ms" << endl;
+        cout << "Diff of object with itself: " << sameMs << " ms" << endl;
+        cout << "Diff of equal copy: " << equalMs << " ms" << endl;
+    }
+
+    { // Compact text for the wire and pretty text for logs after every small edit
+        JsonObject cached, plain;
+        cached.parse(text);
+        plain.parse(text);
+        cached.setStringifyCache(true);
+
+        JsonObject patch;
+        patch.parse(string("[{\"op\":\"replace\",\"path\":\"/1234/age\",\"value\":42}]"));
+
+        auto alternate = [&](JsonObject &obj) {
+            obj.applyPatch(patch);
+            obj.stringify(JsonObject::MODE_COMPACT);
+            obj.stringify(JsonObject::MODE_2_SPACES);
+        };
+
+        alternate(cached);
+        double cachedMs = measure(10, [&]() { alternate(cached); }) / 2;
+        double plainMs = measure(10, [&]() { alternate(plain); }) / 2;
+
+        cout << "Stringify with alternating modes: " << plainMs << " ms, cached: " << cachedMs << " ms" << endl;
+    }
+
+    { // Validation throughput
+        size_t offset = 0;
+        double validateMs = measure(20, [&]() { JsonObject::validate(text, offset); });
+        cout << "Validate: " << text.size() / validateMs / 1e6 << " GB/s" << endl;
+    }
+
+    { // Reformatting throughput compared to plain copy
+        string compact = JsonFormatter::format(text, JsonObject::MODE_COMPACT);
+        string copy(text.size(), ' ');
+
+        double copyMs = measure(20, [&]() { memcpy(&copy[0], text.data(), text.size()); });
+        double minifyMs = measure(20, [&]() { JsonFormatter::format(text, JsonObject::MODE_COMPACT); });
+        double prettyMs = measure(20, [&]() { JsonFormatter::format(compact, JsonObject::MODE_2_SPACES); });
+        double recompactMs = measure(20, [&]() { JsonFormatter::format(compact, JsonObject::MODE_COMPACT); });
+
+        cout << "Memcpy: " << text.size() / copyMs / 1e6 << " GB/s" << endl;
+        cout << "Minify: " << text.size() / minifyMs / 1e6 << " GB/s" << endl;
+        cout << "Pretty-print: " << compact.size() / prettyMs / 1e6 << " GB/s" << endl;
+        cout << "Minify of compact text: " << compact.size() / recompactMs / 1e6 << " GB/s" << endl;
+    }
+
+    return 0;
+}
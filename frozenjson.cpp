@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#include "frozenjson.h"
+
+FrozenJson::FrozenJson()
+{
+    m_nodes.resize(1);
+}
+
+FrozenJson::FrozenJson(const JsonObject &obj) : FrozenJson()
+{
+    // Breadth-first walk: all children of a container are appended in one go,
+    // so they end up in a contiguous range [first, first + size)
+    std::vector<const JsonObject*> sources;
+    sources.push_back(&obj);
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const JsonObject *src = sources[i];
+        Node &node = m_nodes[i];
+        node.type = src->m_type;
+
+        switch (src->m_type) {
+        case JsonObject::JSON_BOOL:
+            node.number = src->m_value == "true" ? 1. : 0.;
+            break;
+        case JsonObject::JSON_NUMBER:
+            node.number = std::strtod(src->m_value.c_str(), nullptr);
+            break;
+        case JsonObject::JSON_STRING:
+            node.first = _store(src->m_value);
+            node.size = static_cast<uint32_t>(src->m_value.size());
+            break;
+        case JsonObject::JSON_ARRAY: {
+            uint32_t first = _allocate(src->m_array.size());
+            m_nodes[i].first = first;
+            m_nodes[i].size = static_cast<uint32_t>(src->m_array.size());
+
+            for (auto &it: src->m_array)
+                sources.push_back(&it);
+            break;
+        }
+        case JsonObject::JSON_OBJECT: {
+            uint32_t first = _allocate(src->m_map.size());
+            m_nodes[i].first = first;
+            m_nodes[i].size = static_cast<uint32_t>(src->m_map.size());
+
+            // std::map keeps keys sorted, so the children are ready for binary search
+            uint32_t child = first;
+            for (auto &it: src->m_map) {
+                m_nodes[child].keyOffset = _store(it.first);
+                m_nodes[child].keySize = static_cast<uint32_t>(it.first.size());
+                sources.push_back(&it.second);
+                ++child;
+            }
+            break;
+        }
+        default: break;
+        }
+    }
+
+    m_nodes.shrink_to_fit();
+    m_pool.shrink_to_fit();
+}
+
+FrozenJson::Value FrozenJson::root() const
+{
+    return Value(this, 0);
+}
+
+size_t FrozenJson::memoryUsage() const
+{
+    return m_nodes.capacity() * sizeof(Node) + m_pool.capacity();
+}
+
+uint32_t FrozenJson::_allocate(size_t count)
+{
+    // node indexes are 32-bit to keep nodes small
+    if (count > std::numeric_limits<uint32_t>::max() - m_nodes.size())
+        throw std::length_error("FrozenJson: too many nodes");
+
+    uint32_t first = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.resize(m_nodes.size() + count);
+    return first;
+}
+
+uint32_t FrozenJson::_store(const std::string &text)
+{
+    // text offsets and lengths are 32-bit as well
+    if (text.size() > std::numeric_limits<uint32_t>::max() - m_pool.size())
+        throw std::length_error("FrozenJson: text exceeds 4 GiB");
+
+    uint32_t offset = static_cast<uint32_t>(m_pool.size());
+    m_pool += text;
+    return offset;
+}
+
+FrozenJson::Value::Value(const FrozenJson *doc, uint32_t index) :
+    m_doc(doc), m_index(index)
+{
+}
+
+const FrozenJson::Node *FrozenJson::Value::node() const
+{
+    if (!m_doc) return nullptr;
+    return &m_doc->m_nodes[m_index];
+}
+
+std::string_view FrozenJson::Value::key(uint32_t index) const
+{
+    const Node &child = m_doc->m_nodes[index];
+    return std::string_view(m_doc->m_pool.data() + child.keyOffset, child.keySize);
+}
+
+JsonObject::Type FrozenJson::Value::type() const
+{
+    const Node *n = node();
+    return n ? n->type : JsonObject::JSON_NULL;
+}
+
+std::vector<std::string_view> FrozenJson::Value::keys() const
+{
+    std::vector<std::string_view> result;
+    const Node *n = node();
+    if (!n || n->type != JsonObject::JSON_OBJECT)
+        return result;
+
+    result.reserve(n->size);
+    for (uint32_t i = n->first; i < n->first + n->size; ++i)
+        result.push_back(key(i));
+
+    return result;
+}
+
+bool FrozenJson::Value::exist(std::string_view key) const
+{
+    return value(key).m_doc != nullptr;
+}
+
+FrozenJson::Value FrozenJson::Value::value(std::string_view key) const
+{
+    const Node *n = node();
+    if (!n || n->type != JsonObject::JSON_OBJECT)
+        return {};
+
+    uint32_t low = n->first, high = n->first + n->size;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int cmp = this->key(middle).compare(key);
+
+        if (cmp == 0)
+            return Value(m_doc, middle);
+        else if (cmp < 0)
+            low = middle + 1;
+        else high = middle;
+    }
+
+    return {};
+}
+
+FrozenJson::Value FrozenJson::Value::at(size_t index) const
+{
+    const Node *n = node();
+    if (!n || n->type != JsonObject::JSON_ARRAY || index >= n->size)
+        return {};
+
+    return Value(m_doc, n->first + static_cast<uint32_t>(index));
+}
+
+size_t FrozenJson::Value::size() const
+{
+    const Node *n = node();
+    if (n && (n->type == JsonObject::JSON_OBJECT || n->type == JsonObject::JSON_ARRAY))
+        return n->size;
+
+    return 0;
+}
+
+bool FrozenJson::Value::toBool(bool defVal) const
+{
+    const Node *n = node();
+    if (n && n->type == JsonObject::JSON_BOOL)
+        return n->number != 0.;
+
+    return defVal;
+}
+
+double FrozenJson::Value::toNumber(double defVal) const
+{
+    const Node *n = node();
+    if (n && n->type == JsonObject::JSON_NUMBER)
+        return n->number;
+
+    return defVal;
+}
+
+std::string_view FrozenJson::Value::toString(std::string_view defVal) const
+{
+    const Node *n = node();
+    if (n && n->type == JsonObject::JSON_STRING)
+        return std::string_view(m_doc->m_pool.data() + n->first, n->size);
+
+    return defVal;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "jsonobject.h"
+
+/// \brief The FrozenJson class is an immutable, read-optimized copy of a JsonObject.
+/// All nodes are stored in one array where children of a container lie next
+/// to each other, keys are kept sorted for binary search and all text
+/// lives in a single string pool. Since nothing is modified after construction,
+/// one instance can be read from many threads at the same time without locks.
+class FrozenJson
+{
+    struct Node
+    {
+        JsonObject::Type type = JsonObject::JSON_NULL;
+        uint32_t first = 0;     /// index of the first child or offset of the text in the pool
+        uint32_t size = 0;      /// number of children or length of the text
+        uint32_t keyOffset = 0; /// offset of the key in the pool if parent is JSON_OBJECT
+        uint32_t keySize = 0;   /// length of the key
+        double number = 0.;     /// parsed value for JSON_NUMBER and JSON_BOOL
+    };
+
+public:
+
+    /// \brief The Value class is a lightweight reference to a node of FrozenJson.
+    /// It is valid as long as the FrozenJson it was taken from is alive.
+    class Value
+    {
+    public:
+        Value() = default;
+
+        /// \brief type - returns type of the content.
+        JsonObject::Type type() const;
+
+        /// \brief keys - returns array of sorted keys if type is JSON_OBJECT
+        std::vector<std::string_view> keys() const;
+
+        /// \brief exist - returns 'true' if given key is exist in object
+        bool exist(std::string_view key) const;
+
+        /// \brief value - returns Value if key exist, otherwise Value with type JSON_NULL
+        Value value(std::string_view key) const;
+
+        /// \brief at - returns Value by index if type is JSON_ARRAY
+        /// otherwise Value with 'null'
+        Value at(size_t index) const;
+
+        /// \brief size - returns the number of stored elements if type is JSON_OBJECT or JSON_ARRAY
+        size_t size() const;
+
+        /// \brief toBool - returns contained value if type is JSON_BOOL
+        bool toBool(bool defVal = false) const;
+
+        /// \brief toNumber - returns contained value if type is JSON_NUMBER
+        double toNumber(double defVal = 0.) const;
+
+        /// \brief toString - returns contained value if type is JSON_STRING
+        std::string_view toString(std::string_view defVal = {}) const;
+
+    private:
+        Value(const FrozenJson *doc, uint32_t index);
+        const Node *node() const;
+        std::string_view key(uint32_t index) const;
+
+        const FrozenJson *m_doc = nullptr;
+        uint32_t m_index = 0;
+
+        friend class FrozenJson;
+    };
+
+    /// \brief FrozenJson Creates an empty document with 'null' root
+    FrozenJson();
+
+    /// \brief FrozenJson Creates a compacted copy of the given object
+    /// throws std::length_error if the object has more than 2^32 nodes or 4 GiB of text
+    explicit FrozenJson(const JsonObject &obj);
+
+    /// \brief root - returns reference to the top-level value
+    Value root() const;
+
+    /// \brief memoryUsage - returns the number of bytes occupied by nodes and text
+    size_t memoryUsage() const;
+
+private:
+    std::vector<Node> m_nodes;
+    std::string m_pool;
+
+    uint32_t _allocate(size_t count);
+    uint32_t _store(const std::string &text);
+};
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include "jsonarrayreader.h"
+#include "jsonswar.h"
+
+JsonArrayReader::JsonArrayReader()
+{
+}
+
+JsonArrayReader::JsonArrayReader(const char *data, size_t len) :
+    m_external(data), m_externalSize(len), m_finished(true)
+{
+}
+
+void JsonArrayReader::feed(const char *data, size_t len)
+{
+    if (m_external || m_finished)
+        return;
+
+    // drop everything before the unfinished element
+    size_t keep = m_inElement ? m_elementStart : m_pos;
+    if (keep > 0) {
+        m_buffer.erase(0, keep);
+        m_base += keep;
+        m_pos -= keep;
+        m_elementStart -= std::min(m_elementStart, keep);
+    }
+
+    m_buffer.append(data, len);
+}
+
+void JsonArrayReader::finish()
+{
+    m_finished = true;
+}
+
+JsonArrayReader::Status JsonArrayReader::next(JsonObject &element)
+{
+    if (m_status == READ_END || m_status == READ_ERROR)
+        return m_status;
+
+    const char *data = m_external ? m_external : m_buffer.data();
+    size_t len = m_external ? m_externalSize : m_buffer.size();
+
+    while (m_pos < len) {
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+                ++m_pos;
+                continue;
+            }
+
+            // jump to the next quote or backslash
+            size_t pos = m_pos;
+            while (pos + 8 <= len) {
+                uint64_t word = swarLoad(data + pos);
+                uint64_t mask = swarEqualBytes(word, '"') | swarEqualBytes(word, '\\');
+                if (mask) {
+                    pos += swarFirstByte(mask);
+                    break;
+                }
+                pos += 8;
+            }
+
+            m_pos = pos;
+            if (m_pos == len)
+                break;
+
+            char symbol = data[m_pos++];
+            if (symbol == '\\') m_escape = true;
+            else if (symbol == '"') m_inString = false;
+            continue;
+        }
+
+        char symbol = data[m_pos];
+        if (jsonIsSpace(symbol)) {
+            m_pos = jsonSkipSpaces(data, len, m_pos);
+            continue;
+        }
+
+        if (!m_inElement) {
+            switch (m_state) {
+            case STATE_START:
+                if (symbol != '[') return _fail(m_pos);
+                m_state = STATE_FIRST;
+                ++m_pos;
+                continue;
+            case STATE_NEXT:
+                if (symbol == ',') {
+                    m_state = STATE_VALUE;
+                    ++m_pos;
+                    continue;
+                }
+                // fall through
+            case STATE_FIRST:
+                if (symbol == ']' && m_state != STATE_VALUE) {
+                    // the end is reported when it's known that only spaces follow
+                    m_state = STATE_DONE;
+                    ++m_pos;
+                    continue;
+                }
+                if (m_state == STATE_NEXT) return _fail(m_pos);
+                break;
+            case STATE_DONE: // text after the array
+                return _fail(m_pos);
+            default:
+                break;
+            }
+
+            if (symbol == ',' || symbol == ']') return _fail(m_pos);
+
+            m_inElement = true;
+            m_elementStart = m_pos;
+        }
+
+        if (symbol == '"') {
+            m_inString = true;
+        }
+        else if (symbol == '{' || symbol == '[') {
+            ++m_depth;
+        }
+        else if ((symbol == '}' || symbol == ']') && m_depth > 0) {
+            --m_depth;
+        }
+        else if ((symbol == ',' || symbol == ']') && m_depth == 0) {
+            size_t errPos = element.parse(data + m_elementStart, m_pos - m_elementStart);
+            if (errPos > 0) return _fail(m_elementStart + errPos);
+
+            m_inElement = false;
+            m_state = STATE_NEXT;
+            return m_status = READ_ELEMENT;
+        }
+
+        ++m_pos;
+    }
+
+    if (m_state == STATE_DONE && m_finished)
+        return m_status = READ_END;
+
+    if (m_finished)
+        return _fail(len);
+
+    return m_status = READ_NEED_MORE;
+}
+
+size_t JsonArrayReader::errorOffset() const
+{
+    return m_errorOffset;
+}
+
+JsonArrayReader::Status JsonArrayReader::_fail(size_t pos)
+{
+    m_errorOffset = m_base + pos;
+    return m_status = READ_ERROR;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "jsonobject.h"
+
+/// \brief The JsonArrayReader class parses elements of a top-level JSON array one by one.
+/// Text can be given at once (buffer or mapped file, without copying) or fed in chunks.
+/// When the next element is not complete yet, next() returns READ_NEED_MORE, so the caller
+/// can wait for more input and continue later. Only the unfinished element is kept
+/// in memory, if chunks are fed after READ_NEED_MORE. Text fed in chunks ends with finish(),
+/// until then READ_NEED_MORE is returned after the closing bracket too.
+class JsonArrayReader
+{
+public:
+
+    /// \brief The Status enum describes result of next()
+    enum Status
+    {
+        READ_ELEMENT,       /// element is parsed
+        READ_NEED_MORE,     /// element is not complete, feed() more text or call finish()
+        READ_END,           /// closing bracket of the array is reached and only spaces follow it
+        READ_ERROR          /// text is malformed, see errorOffset()
+    };
+
+    /// \brief JsonArrayReader Creates reader for text fed in chunks
+    JsonArrayReader();
+
+    /// \brief JsonArrayReader Creates reader for complete text, the text is not copied
+    /// and must stay valid while reading
+    JsonArrayReader(const char *data, size_t len);
+
+    /// \brief feed - appends next chunk of the text
+    void feed(const char *data, size_t len);
+
+    /// \brief finish - marks the end of the text, after it READ_NEED_MORE turns to READ_ERROR
+    void finish();
+
+    /// \brief next - parses the next element of the array
+    /// \param element - receives parsed element if READ_ELEMENT is returned
+    /// \return reading status
+    Status next(JsonObject &element);
+
+    /// \brief errorOffset - returns index of the symbol in the whole text where error was found
+    size_t errorOffset() const;
+
+private:
+    enum State
+    {
+        STATE_START,    /// waiting for '['
+        STATE_FIRST,    /// first element or ']'
+        STATE_VALUE,    /// element after ','
+        STATE_NEXT,     /// ',' or ']' after element
+        STATE_DONE
+    };
+
+    std::string m_buffer;
+    const char *m_external = nullptr;
+    size_t m_externalSize = 0;
+
+    size_t m_base = 0;          /// offset of m_buffer in the whole text
+    size_t m_pos = 0;           /// scanning position in m_buffer
+    size_t m_elementStart = 0;  /// beginning of the current element in m_buffer
+    size_t m_errorOffset = 0;
+
+    State m_state = STATE_START;
+    Status m_status = READ_NEED_MORE;
+    size_t m_depth = 0;
+    bool m_inElement = false;
+    bool m_inString = false;
+    bool m_escape = false;
+    bool m_finished = false;
+
+    Status _fail(size_t pos);
+};
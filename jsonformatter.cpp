@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <cstring>
+#include <algorithm>
+
+#include "jsonformatter.h"
+#include "jsonswar.h"
+
+enum SymbolKind : uint8_t {
+    SYMBOL_SPACE = 1,
+    SYMBOL_QUOTE = 2,
+    SYMBOL_STRUCTURAL = 4
+};
+
+// kind of every byte outside of strings, 0 - part of a number or literal
+static const struct SymbolTable {
+    uint8_t kinds[256] = {};
+
+    SymbolTable()
+    {
+        for (unsigned char symbol : {' ', '\n', '\r', '\t'})
+            kinds[symbol] = SYMBOL_SPACE;
+        for (unsigned char symbol : {'{', '}', '[', ']', ',', ':'})
+            kinds[symbol] = SYMBOL_STRUCTURAL;
+        kinds[static_cast<unsigned char>('"')] = SYMBOL_QUOTE;
+    }
+} SYMBOLS;
+
+JsonFormatter::JsonFormatter(JsonObject::StringifyMode mode, Sink sink) :
+    m_mode(mode), m_sink(std::move(sink))
+{
+}
+
+void JsonFormatter::write(const char *data, size_t len)
+{
+    size_t pos = 0;
+
+    while (pos < len) {
+        // strings, numbers, literals and in compact mode also structural
+        // symbols are copied as one run up to the next space
+        size_t run = pos;
+        pos = _scan(data, len, pos);
+
+        if (pos > run) {
+            if (m_opened) {
+                m_opened = false;
+                _newLine();
+            }
+            _append(data + run, pos - run);
+        }
+
+        if (pos == len)
+            break;
+
+        char symbol = data[pos];
+        if (SYMBOLS.kinds[static_cast<unsigned char>(symbol)] == SYMBOL_SPACE) {
+            pos = jsonSkipSpaces(data, len, pos);
+            continue;
+        }
+
+        ++pos;
+
+        switch (symbol) {
+        case '{': case '[':
+            if (m_opened)
+                _newLine();
+
+            _append(symbol);
+            ++m_depth;
+            m_opened = true;
+            break;
+        case '}': case ']':
+            if (m_depth > 0) --m_depth;
+
+            // empty container stays on one line
+            if (m_opened) m_opened = false;
+            else _newLine();
+
+            _append(symbol);
+            break;
+        case ',':
+            _append(',');
+            _newLine();
+            break;
+        case ':':
+            _append(':');
+            _append(' ');
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+size_t JsonFormatter::_scan(const char *data, size_t len, size_t pos)
+{
+    // spaces end a run, structural symbols too unless they are copied as is
+    uint8_t stop = m_mode == JsonObject::MODE_COMPACT ? SYMBOL_SPACE : SYMBOL_SPACE | SYMBOL_STRUCTURAL;
+
+    while (pos < len) {
+        if (m_inString) { // up to the closing quote as is
+            if (m_escape) { // escaped symbol left from the previous chunk
+                m_escape = false;
+                ++pos;
+            }
+
+            while (pos < len) {
+                // jump to the next quote or backslash
+                while (pos + 8 <= len) {
+                    uint64_t word = swarLoad(data + pos);
+                    uint64_t mask = swarEqualBytes(word, '"') | swarEqualBytes(word, '\\');
+                    if (mask) {
+                        pos += swarFirstByte(mask);
+                        break;
+                    }
+                    pos += 8;
+                }
+
+                if (pos >= len)
+                    break;
+
+                char symbol = data[pos];
+                if (symbol == '"') {
+                    m_inString = false;
+                    ++pos;
+                    break;
+                }
+                else if (symbol == '\\') {
+                    pos += 2;
+                    if (pos > len) {
+                        pos = len;
+                        m_escape = true;
+                    }
+                }
+                else ++pos;
+            }
+            continue;
+        }
+
+        // numbers, literals and symbols between tokens are a few bytes long,
+        // the table is faster for them than word-at-a-time masks
+        uint8_t kind = SYMBOLS.kinds[static_cast<unsigned char>(data[pos])];
+        if (kind & stop)
+            return pos;
+
+        m_inString = kind == SYMBOL_QUOTE;
+        ++pos;
+    }
+
+    return len;
+}
+
+void JsonFormatter::finish()
+{
+    if (m_size > 0)
+        m_sink(m_buffer, m_size);
+
+    m_size = 0;
+    m_depth = 0;
+    m_inString = false;
+    m_escape = false;
+    m_opened = false;
+}
+
+std::string JsonFormatter::format(const char *data, size_t len, JsonObject::StringifyMode mode)
+{
+    std::string result;
+    result.reserve(len);
+
+    JsonFormatter formatter(mode, [&result](const char *text, size_t size) {
+        result.append(text, size);
+    });
+
+    formatter.write(data, len);
+    formatter.finish();
+    return result;
+}
+
+std::string JsonFormatter::format(const std::string &data, JsonObject::StringifyMode mode)
+{
+    return format(data.data(), data.size(), mode);
+}
+
+void JsonFormatter::_append(const char *data, size_t len)
+{
+    if (m_size + len > BUFFER_SIZE) {
+        if (m_size > 0)
+            m_sink(m_buffer, m_size);
+        m_size = 0;
+
+        // large runs bypass the buffer
+        if (len > BUFFER_SIZE) {
+            m_sink(data, len);
+            return;
+        }
+    }
+
+    memcpy(m_buffer + m_size, data, len);
+    m_size += len;
+}
+
+void JsonFormatter::_append(char symbol)
+{
+    if (m_size == BUFFER_SIZE) {
+        m_sink(m_buffer, m_size);
+        m_size = 0;
+    }
+
+    m_buffer[m_size++] = symbol;
+}
+
+void JsonFormatter::_newLine()
+{
+    if (m_mode == JsonObject::MODE_COMPACT)
+        return;
+
+    size_t spaces = m_depth * static_cast<size_t>(m_mode);
+
+    // usual case: line break and indent fit into the buffer at once
+    if (m_size + spaces < BUFFER_SIZE) {
+        m_buffer[m_size] = '\n';
+        memset(m_buffer + m_size + 1, ' ', spaces);
+        m_size += spaces + 1;
+        return;
+    }
+
+    _append('\n');
+
+    while (spaces > 0) {
+        size_t count = std::min(spaces, BUFFER_SIZE - m_size);
+        if (count == 0) {
+            m_sink(m_buffer, m_size);
+            m_size = 0;
+            continue;
+        }
+
+        memset(m_buffer + m_size, ' ', count);
+        m_size += count;
+        spaces -= count;
+    }
+}
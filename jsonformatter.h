@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include "jsonobject.h"
+
+/// \brief The JsonFormatter class reformats JSON text to the given StringifyMode
+/// without building JsonObject. Tokens keep their original order, memory usage
+/// doesn't depend on the input size and text may be passed in chunks of any size.
+/// Input is expected to be valid JSON, check it with JsonObject::validate() if needed.
+class JsonFormatter
+{
+public:
+    /// \brief Sink - receives formatted text in portions
+    using Sink = std::function<void(const char *data, size_t len)>;
+
+    /// \brief JsonFormatter Creates formatter that passes result to the sink
+    /// \param mode - StringifyMode describes text representation mode
+    /// \param sink - receiver of the formatted text
+    JsonFormatter(JsonObject::StringifyMode mode, Sink sink);
+
+    /// \brief write - formats next chunk of the input text
+    void write(const char *data, size_t len);
+
+    /// \brief finish - passes the rest of buffered text to the sink
+    /// and prepares formatter for the next document
+    void finish();
+
+    /// \brief format - Converts whole text to the given StringifyMode
+    /// \param data - pinter to the beginning of the text array
+    /// \param len - text size
+    /// \param mode - StringifyMode describes text representation mode
+    /// \return convertation result
+    static std::string format(const char *data, size_t len, JsonObject::StringifyMode mode = JsonObject::MODE_2_SPACES);
+    static std::string format(const std::string &data, JsonObject::StringifyMode mode = JsonObject::MODE_2_SPACES);
+
+private:
+    JsonObject::StringifyMode m_mode;
+    Sink m_sink;
+
+    size_t m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    bool m_opened = false;  /// container was opened and its content is not started yet
+
+    static const size_t BUFFER_SIZE = 4096;
+    char m_buffer[BUFFER_SIZE];
+    size_t m_size = 0;
+
+    size_t _scan(const char *data, size_t len, size_t pos);
+    void _append(const char *data, size_t len);
+    void _append(char symbol);
+    void _newLine();
+};
@@ -21,16 +21,398 @@
 */
 
 #include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <cmath>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <charconv>
+#include <thread>
+#include <atomic>
 
 #include "jsonobject.h"
+#include "jsonswar.h"
 
-const char NUM_SYMBOLS[15] = {'.','0','1','2','3','4','5','6','7','8','9','-','+','e','E'};
+static const size_t VALIDATE_MAX_DEPTH = 4096;
+
+static inline bool isContinuation(const char *data, size_t pos, size_t len,
+                                  unsigned char low = 0x80, unsigned char high = 0xBF)
+{
+    if (pos >= len) return false;
+    unsigned char symbol = static_cast<unsigned char>(data[pos]);
+    return symbol >= low && symbol <= high;
+}
+
+// Returns length of well-formed UTF-8 sequence at 'pos' (Unicode Table 3-7),
+// 0 for overlong forms, surrogates, values above U+10FFFF and truncated sequences
+static size_t utf8SequenceLength(const char *data, size_t len, size_t pos)
+{
+    unsigned char lead = static_cast<unsigned char>(data[pos]);
+
+    if (lead < 0x80)
+        return 1;
+    else if (lead >= 0xC2 && lead <= 0xDF)
+        return isContinuation(data, pos + 1, len) ? 2 : 0;
+    else if (lead >= 0xE0 && lead <= 0xEF) {
+        unsigned char low = lead == 0xE0 ? 0xA0 : 0x80;
+        unsigned char high = lead == 0xED ? 0x9F : 0xBF;
+        return isContinuation(data, pos + 1, len, low, high) &&
+               isContinuation(data, pos + 2, len) ? 3 : 0;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4) {
+        unsigned char low = lead == 0xF0 ? 0x90 : 0x80;
+        unsigned char high = lead == 0xF4 ? 0x8F : 0xBF;
+        return isContinuation(data, pos + 1, len, low, high) &&
+               isContinuation(data, pos + 2, len) &&
+               isContinuation(data, pos + 3, len) ? 4 : 0;
+    }
+
+    return 0;
+}
+
+static inline bool isHex(char symbol)
+{
+    return (symbol >= '0' && symbol <= '9') || (symbol >= 'a' && symbol <= 'f') ||
+           (symbol >= 'A' && symbol <= 'F');
+}
+
+// Checks string starting with quote at 'pos', moves 'pos' past the closing quote.
+// Scanning 8 bytes at once gives about 0.5-0.6 GB/s ("Validate" in JsonObjectBenchmark),
+// several GB/s would need SSE/NEON classification of 16-64 bytes at once;
+// edge cases are pinned by JsonObjectValidateTest for such a change
+static JsonObject::ValidateError validateString(const char *data, size_t len, size_t &pos)
+{
+    ++pos;
+
+    while (true) {
+        // jump over plain ASCII to the next quote, backslash, control or non-ASCII byte
+        while (pos + 8 <= len) {
+            uint64_t word = swarLoad(data + pos);
+            uint64_t mask = swarSpecialBytes(word) | (word & SWAR_HIGHS);
+            if (mask) {
+                pos += swarFirstByte(mask);
+                break;
+            }
+            pos += 8;
+        }
+
+        if (pos >= len)
+            return JsonObject::ERROR_UNEXPECTED_END;
+
+        unsigned char symbol = static_cast<unsigned char>(data[pos]);
+
+        if (symbol == '"') {
+            ++pos;
+            return JsonObject::VALID;
+        }
+        else if (symbol == '\\') {
+            if (pos + 1 >= len) {
+                pos = len;
+                return JsonObject::ERROR_UNEXPECTED_END;
+            }
+
+            char escaped = data[pos + 1];
+            if (escaped == 'u') {
+                for (size_t i = 2; i < 6; ++i) {
+                    if (pos + i >= len) {
+                        pos = len;
+                        return JsonObject::ERROR_UNEXPECTED_END;
+                    }
+                    if (!isHex(data[pos + i])) {
+                        pos += i;
+                        return JsonObject::ERROR_INVALID_STRING;
+                    }
+                }
+                pos += 6;
+            }
+            else if (strchr("\"\\/bfnrt", escaped) && escaped != '\0') {
+                pos += 2;
+            }
+            else {
+                ++pos;
+                return JsonObject::ERROR_INVALID_STRING;
+            }
+        }
+        else if (symbol < 0x20) {
+            return JsonObject::ERROR_INVALID_STRING;
+        }
+        else if (symbol >= 0x80) {
+            // check the whole run of multi-byte sequences before returning to the word scan
+            do {
+                size_t size = utf8SequenceLength(data, len, pos);
+                if (size == 0)
+                    return JsonObject::ERROR_INVALID_UTF8;
+                pos += size;
+            } while (pos < len && static_cast<unsigned char>(data[pos]) >= 0x80);
+        }
+        else ++pos;
+    }
+
+    return JsonObject::ERROR_UNEXPECTED_END;
+}
+
+// Checks number at 'pos' against RFC 8259 grammar, moves 'pos' past the number
+static JsonObject::ValidateError validateNumber(const char *data, size_t len, size_t &pos)
+{
+    auto isDigit = [&](size_t i) { return i < len && data[i] >= '0' && data[i] <= '9'; };
+
+    if (data[pos] == '-')
+        ++pos;
+
+    if (!isDigit(pos))
+        return pos == len ? JsonObject::ERROR_UNEXPECTED_END : JsonObject::ERROR_INVALID_NUMBER;
+
+    if (data[pos] == '0') ++pos;
+    else while (isDigit(pos)) ++pos;
+
+    if (pos < len && data[pos] == '.') {
+        ++pos;
+        if (!isDigit(pos))
+            return pos == len ? JsonObject::ERROR_UNEXPECTED_END : JsonObject::ERROR_INVALID_NUMBER;
+        while (isDigit(pos)) ++pos;
+    }
+
+    if (pos < len && (data[pos] == 'e' || data[pos] == 'E')) {
+        ++pos;
+        if (pos < len && (data[pos] == '+' || data[pos] == '-'))
+            ++pos;
+        if (!isDigit(pos))
+            return pos == len ? JsonObject::ERROR_UNEXPECTED_END : JsonObject::ERROR_INVALID_NUMBER;
+        while (isDigit(pos)) ++pos;
+    }
+
+    return JsonObject::VALID;
+}
+
+// Appends text to result as a JSON string body (RFC 8259),
+// runs without quotes, backslashes and control characters are copied at once
+static void escapeString(const std::string &text, std::string &result)
+{
+    static const char HEX[] = "0123456789abcdef";
+    const char *data = text.data();
+    size_t len = text.size(), step = 0, run = 0;
+
+    result.reserve(result.size() + len + 2);
+
+    while (step < len) {
+        if (step + 8 <= len) {
+            uint64_t mask = swarSpecialBytes(swarLoad(data + step));
+            if (!mask) {
+                step += 8;
+                continue;
+            }
+            step += swarFirstByte(mask);
+        }
+
+        unsigned char symbol = static_cast<unsigned char>(data[step]);
+        if (symbol != '"' && symbol != '\\' && symbol >= 0x20) {
+            ++step;
+            continue;
+        }
+
+        result.append(data + run, step - run);
+        result += '\\';
+
+        switch (symbol) {
+        case '"': result += '"'; break;
+        case '\\': result += '\\'; break;
+        case '\b': result += 'b'; break;
+        case '\f': result += 'f'; break;
+        case '\n': result += 'n'; break;
+        case '\r': result += 'r'; break;
+        case '\t': result += 't'; break;
+        default:
+            result += "u00";
+            result += HEX[symbol >> 4];
+            result += HEX[symbol & 0x0F];
+            break;
+        }
+
+        run = ++step;
+    }
+
+    result.append(data + run, len - run);
+}
+
+static bool parseHex4(const char *data, uint32_t &code)
+{
+    code = 0;
+    for (int i = 0; i < 4; ++i) {
+        char symbol = data[i];
+        code <<= 4;
+
+        if (symbol >= '0' && symbol <= '9') code |= static_cast<uint32_t>(symbol - '0');
+        else if (symbol >= 'a' && symbol <= 'f') code |= static_cast<uint32_t>(symbol - 'a' + 10);
+        else if (symbol >= 'A' && symbol <= 'F') code |= static_cast<uint32_t>(symbol - 'A' + 10);
+        else return false;
+    }
+
+    return true;
+}
+
+static void appendUtf8(uint32_t code, std::string &result)
+{
+    if (code < 0x80) {
+        result += static_cast<char>(code);
+    }
+    else if (code < 0x800) {
+        result += static_cast<char>(0xC0 | (code >> 6));
+        result += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000) {
+        result += static_cast<char>(0xE0 | (code >> 12));
+        result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else {
+        result += static_cast<char>(0xF0 | (code >> 18));
+        result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+// Appends decoded body of a JSON string to result,
+// returns 'false' on invalid escape sequence or unpaired surrogate
+static bool unescapeString(const char *data, size_t len, std::string &result)
+{
+    size_t step = 0;
+
+    while (step < len) {
+        const char *slash = static_cast<const char*>(memchr(data + step, '\\', len - step));
+        if (!slash) {
+            result.append(data + step, len - step);
+            return true;
+        }
+
+        size_t pos = static_cast<size_t>(slash - data);
+        result.append(data + step, pos - step);
+
+        if (pos + 1 >= len)
+            return false;
+
+        char symbol = data[pos + 1];
+        step = pos + 2;
+
+        switch (symbol) {
+        case '"': result += '"'; break;
+        case '\\': result += '\\'; break;
+        case '/': result += '/'; break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'n': result += '\n'; break;
+        case 'r': result += '\r'; break;
+        case 't': result += '\t'; break;
+        case 'u': {
+            uint32_t code = 0;
+            if (step + 4 > len || !parseHex4(data + step, code))
+                return false;
+            step += 4;
+
+            if (code >= 0xD800 && code <= 0xDBFF) { // high surrogate, low one must follow
+                uint32_t low = 0;
+                if (step + 6 > len || data[step] != '\\' || data[step + 1] != 'u' ||
+                    !parseHex4(data + step + 2, low) || low < 0xDC00 || low > 0xDFFF)
+                    return false;
+
+                step += 6;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            else if (code >= 0xDC00 && code <= 0xDFFF) {
+                return false;
+            }
+
+            appendUtf8(code, result);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// JSON Pointer (RFC 6901) reference token escaping: '~' -> "~0", '/' -> "~1"
+static void appendPointerToken(const std::string &key, std::string &result)
+{
+    if (key.find_first_of("~/") == std::string::npos) {
+        result += key;
+        return;
+    }
+
+    for (char symbol: key) {
+        if (symbol == '~') result += "~0";
+        else if (symbol == '/') result += "~1";
+        else result += symbol;
+    }
+}
+
+static std::string decodePointerToken(const char *data, size_t len)
+{
+    std::string result;
+    result.reserve(len);
+
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] == '~' && i + 1 < len && (data[i + 1] == '0' || data[i + 1] == '1')) {
+            result += data[i + 1] == '0' ? '~' : '/';
+            ++i;
+        }
+        else result += data[i];
+    }
+
+    return result;
+}
+
+// Array index of JSON Pointer: digits without leading zeros
+static bool pointerIndex(const std::string &token, size_t &index)
+{
+    if (token.empty() || token.size() > 18) return false;
+    if (token.size() > 1 && token[0] == '0') return false;
+
+    index = 0;
+    for (char symbol: token) {
+        if (symbol < '0' || symbol > '9') return false;
+        index = index * 10 + static_cast<size_t>(symbol - '0');
+    }
+
+    return true;
+}
+
+// Whole text of a number as double. std::from_chars for floating point
+// needs GCC 11, so strtod is used, text of JSON_NUMBER ends with '\0'
+static bool numberValue(const std::string &text, double &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    value = std::strtod(text.c_str(), &end);
+
+    if (end != text.c_str() + text.size() || text.empty())
+        return false;
+
+    return !(errno == ERANGE && std::fabs(value) == HUGE_VAL);
+}
+
+// Unique id of a new content state. Every thread takes ids from the shared
+// counter in blocks, so parsing in parallel doesn't fight for one atomic
+static uint64_t nextContentId()
+{
+    static std::atomic<uint64_t> shared(1);
+    static thread_local uint64_t next = 0, last = 0;
+    const uint64_t block = 1 << 16;
+
+    if (next == last) {
+        next = shared.fetch_add(block, std::memory_order_relaxed);
+        last = next + block;
+    }
+
+    return next++;
+}
 
 JsonObject::JsonObject()
 {
-    m_keys.clear();
 }
 
 JsonObject::JsonObject(bool value) : JsonObject()
@@ -85,79 +467,229 @@ JsonObject::JsonObject(std::vector<JsonObject> &&value) : JsonObject()
     m_array = std::move(value);
 }
 
+JsonObject::~JsonObject()
+{
+    if (m_array.empty() && m_map.empty())
+        return;
+
+    // nested containers are moved out and destroyed one by one,
+    // so every destructor call sees children without own containers
+    std::vector<JsonObject> pending;
+    _detachChildren(pending);
+
+    while (!pending.empty()) {
+        JsonObject obj = std::move(pending.back());
+        pending.pop_back();
+        obj._detachChildren(pending);
+    }
+}
+
 size_t JsonObject::parse(const char *data, size_t len)
 {
-    if (len < 2) return 1;
+    return parse(data, len, ParseOptions());
+}
 
-    clear();
+size_t JsonObject::parse(const std::string &data)
+{
+    return parse(data.data(), data.size());
+}
 
-    size_t step = 0, errPos = 1, end = 0;
-    for (step = 0; step < len; ++step) {
-        char symbol = data[step];
+size_t JsonObject::reparse(const char *data, size_t len)
+{
+    ParseOptions options;
+    options.reuse = true;
+    return parse(data, len, options);
+}
 
-        if (symbol == '{') {
-            errPos = _parseObject(data + step, len - step, end, *this);
-            break;
+size_t JsonObject::reparse(const std::string &data)
+{
+    return reparse(data.data(), data.size());
+}
+
+size_t JsonObject::parse(const char *data, size_t len, const ParseOptions &options)
+{
+    size_t errPos = 0;
+    bool success = false;
+
+    if (options.strict && validate(data, len, errPos) != VALID) {
+        clear();
+    }
+    else success = _parse(data, len, options, errPos);
+
+    if (success)
+        return 0;
+
+    m_type = JsonObject::JSON_ERROR;
+    return errPos > 0 ? errPos : 1; // 0 is reserved for success
+}
+
+JsonObject::ValidateError JsonObject::validate(const std::string &data, size_t &offset)
+{
+    return validate(data.data(), data.size(), offset);
+}
+
+JsonObject::ValidateError JsonObject::validate(const char *data, size_t len, size_t &offset)
+{
+    enum State {
+        STATE_VALUE,    // any value
+        STATE_KEY,      // key with colon
+        STATE_NEXT      // ',' or closing bracket after value
+    };
+
+    // one bit per nesting level: 1 - object, 0 - array
+    uint64_t stack[VALIDATE_MAX_DEPTH / 64];
+    size_t depth = 0, pos = 0;
+    State state = STATE_VALUE;
+    ValidateError error = VALID;
+
+    while (error == VALID) {
+        pos = jsonSkipSpaces(data, len, pos);
+
+        if (depth == 0 && state == STATE_NEXT) { // top-level value is complete
+            offset = pos;
+            return pos == len ? VALID : ERROR_UNEXPECTED_SYMBOL;
         }
-        else if (symbol == '[') {
-            errPos = _parseArray(data + step, len - step, end, *this);
+
+        if (pos == len) {
+            error = ERROR_UNEXPECTED_END;
             break;
         }
-        else if (symbol == ' ' || symbol == '\n' || symbol == '\r') {
-            continue;
-        }
-        else {
-            errPos = step;
+
+        char symbol = data[pos];
+
+        switch (state) {
+        case STATE_VALUE:
+            if (symbol == '{' || symbol == '[') {
+                if (depth == VALIDATE_MAX_DEPTH) {
+                    error = ERROR_TOO_DEEP;
+                    break;
+                }
+
+                uint64_t bit = 1ULL << (depth % 64);
+                if (symbol == '{') stack[depth / 64] |= bit;
+                else stack[depth / 64] &= ~bit;
+                ++depth;
+
+                // empty container is closed right away
+                pos = jsonSkipSpaces(data, len, pos + 1);
+                if (pos < len && data[pos] == (symbol == '{' ? '}' : ']')) {
+                    --depth;
+                    ++pos;
+                    state = STATE_NEXT;
+                }
+                else state = symbol == '{' ? STATE_KEY : STATE_VALUE;
+            }
+            else if (symbol == '"') {
+                error = validateString(data, len, pos);
+                state = STATE_NEXT;
+            }
+            else if (symbol == '-' || (symbol >= '0' && symbol <= '9')) {
+                error = validateNumber(data, len, pos);
+                state = STATE_NEXT;
+            }
+            else if (symbol == 't' || symbol == 'f' || symbol == 'n') {
+                const char *word = symbol == 't' ? "true" : (symbol == 'f' ? "false" : "null");
+                size_t size = symbol == 'f' ? 5 : 4;
+
+                for (size_t i = 0; i < size; ++i, ++pos) {
+                    if (pos == len) {
+                        error = ERROR_UNEXPECTED_END;
+                        break;
+                    }
+                    if (data[pos] != word[i]) {
+                        error = ERROR_UNEXPECTED_SYMBOL;
+                        break;
+                    }
+                }
+                state = STATE_NEXT;
+            }
+            else error = ERROR_UNEXPECTED_SYMBOL;
+            break;
+        case STATE_KEY:
+            if (symbol != '"') {
+                error = ERROR_UNEXPECTED_SYMBOL;
+                break;
+            }
+
+            error = validateString(data, len, pos);
+            if (error != VALID) break;
+
+            pos = jsonSkipSpaces(data, len, pos);
+            if (pos == len) error = ERROR_UNEXPECTED_END;
+            else if (data[pos] != ':') error = ERROR_UNEXPECTED_SYMBOL;
+            else {
+                ++pos;
+                state = STATE_VALUE;
+            }
+            break;
+        case STATE_NEXT: {
+            bool isObject = (stack[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+
+            if (symbol == ',') {
+                ++pos;
+                state = isObject ? STATE_KEY : STATE_VALUE;
+            }
+            else if (symbol == (isObject ? '}' : ']')) {
+                --depth;
+                ++pos;
+            }
+            else error = ERROR_UNEXPECTED_SYMBOL;
             break;
         }
+        }
     }
 
-    return errPos;
+    offset = pos;
+    return error;
 }
 
-size_t JsonObject::parse(const std::string &data)
+std::string JsonObject::stringify(JsonObject::StringifyMode mode)
 {
-    return parse(data.data(), data.size());
+    std::string result;
+    _stringify(result, 0, mode, m_cacheEnabled);
+    return result;
 }
 
-std::string JsonObject::stringify(JsonObject::StringifyMode mode)
+void JsonObject::setStringifyCache(bool enabled)
 {
-    return _stringify(0, mode);
+    m_cacheEnabled = enabled;
+
+    if (!enabled)
+        _releaseCache();
 }
 
-JsonObject::Type JsonObject::type()
+JsonObject::Type JsonObject::type() const
 {
     return m_type;
 }
 
-std::vector<std::string> JsonObject::keys()
+std::vector<std::string> JsonObject::keys() const
 {
-    if (m_keys.size() != m_map.size()) {
-        m_keys.reserve(m_map.size());
+    std::vector<std::string> result;
+    result.reserve(m_map.size());
 
-        for (auto &it: m_map)
-            m_keys.push_back(it.first);
-    }
+    for (auto &it: m_map)
+        result.push_back(it.first);
 
-    return m_keys;
+    return result;
 }
 
-bool JsonObject::exist(const char *key)
+bool JsonObject::exist(const char *key) const
 {
     return exist(std::string(key));
 }
 
-bool JsonObject::exist(const std::string &key)
+bool JsonObject::exist(const std::string &key) const
 {
     return m_map.find(key) != m_map.end();
 }
 
-JsonObject JsonObject::value(const char *key)
+JsonObject JsonObject::value(const char *key) const
 {
     return value(std::string(key));
 }
 
-JsonObject JsonObject::value(const std::string &key)
+JsonObject JsonObject::value(const std::string &key) const
 {
     auto it = m_map.find(key);
     if (it != m_map.end())
@@ -176,6 +708,7 @@ void JsonObject::setValue(const std::string &key, const JsonObject &value)
     if (m_type != JsonObject::JSON_OBJECT)
         clear();
 
+    _invalidate();
     m_type = JsonObject::JSON_OBJECT;
     m_map[key] = value;
 }
@@ -185,11 +718,12 @@ void JsonObject::append(const JsonObject &value)
     if (m_type != JsonObject::JSON_ARRAY)
         clear();
 
+    _invalidate();
     m_type = JsonObject::JSON_ARRAY;
     m_array.push_back(value);
 }
 
-JsonObject JsonObject::at(size_t index)
+JsonObject JsonObject::at(size_t index) const
 {
     if (index >= m_array.size())
         return {};
@@ -197,7 +731,7 @@ JsonObject JsonObject::at(size_t index)
     return m_array.at(index);
 }
 
-size_t JsonObject::size()
+size_t JsonObject::size() const
 {
     if (m_type == JsonObject::JSON_OBJECT)
         return m_map.size();
@@ -208,11 +742,11 @@ size_t JsonObject::size()
 
 void JsonObject::clear()
 {
+    _invalidate();
     m_type = JsonObject::JSON_NULL;
     m_map.clear();
     m_value.clear();
     m_array.clear();
-    m_keys.clear();
 }
 
 void JsonObject::remove(const char *key)
@@ -222,13 +756,14 @@ void JsonObject::remove(const char *key)
 
 void JsonObject::remove(const std::string &key)
 {
-    m_keys.clear();
     auto it = m_map.find(key);
-    if (it != m_map.end())
+    if (it != m_map.end()) {
+        _invalidate();
         m_map.erase(it);
+    }
 }
 
-bool JsonObject::toBool(bool defVal)
+bool JsonObject::toBool(bool defVal) const
 {
     if (m_type == JsonObject::JSON_BOOL)
         return m_value == "true";
@@ -236,7 +771,7 @@ bool JsonObject::toBool(bool defVal)
     return defVal;
 }
 
-double JsonObject::toNumber(double defVal)
+double JsonObject::toNumber(double defVal) const
 {
     if (m_type == JsonObject::JSON_NUMBER)
         return std::stod(m_value);
@@ -244,7 +779,7 @@ double JsonObject::toNumber(double defVal)
     return defVal;
 }
 
-std::string JsonObject::toString(const std::string defVal)
+std::string JsonObject::toString(const std::string defVal) const
 {
     if (m_type == JsonObject::JSON_STRING)
         return m_value;
@@ -252,7 +787,7 @@ std::string JsonObject::toString(const std::string defVal)
     return defVal;
 }
 
-std::vector<JsonObject> JsonObject::toArray()
+std::vector<JsonObject> JsonObject::toArray() const
 {
     if (m_type == JsonObject::JSON_ARRAY)
         return m_array;
@@ -260,7 +795,7 @@ std::vector<JsonObject> JsonObject::toArray()
     return {};
 }
 
-std::map<std::string, JsonObject> JsonObject::toMap()
+std::map<std::string, JsonObject> JsonObject::toMap() const
 {
      if (m_type == JsonObject::JSON_OBJECT)
         return m_map;
@@ -268,37 +803,52 @@ std::map<std::string, JsonObject> JsonObject::toMap()
     return {};
 }
 
-std::string JsonObject::_stringify(size_t indent, StringifyMode mode)
+void JsonObject::_stringify(std::string &result, size_t indent, StringifyMode mode, bool useCache)
 {
-    std::string result;
-    result.reserve(100);
+    bool container = m_type == JsonObject::JSON_ARRAY || m_type == JsonObject::JSON_OBJECT;
+    useCache = useCache && container;
+
+    if (useCache && m_cache) {
+        StringifyCache::Text &cached = m_cache->text(mode);
+        if (cached.valid && (cached.indent == indent || mode == MODE_COMPACT)) {
+            result += cached.text;
+            return;
+        }
+    }
+
+    size_t begin = result.size();
     int8_t spaces = static_cast<int8_t>(mode);
     const char* newLine = (mode == MODE_COMPACT) ? "" : "\n";
 
     switch (m_type) {
     case JsonObject::JSON_NULL:
-        result = std::string("null");
+        result += "null";
         break;
     case JsonObject::JSON_BOOL:
-        result = m_value;
+        result += m_value;
         break;
     case JsonObject::JSON_NUMBER:
-        result = m_value;
+        result += m_value;
         break;
     case JsonObject::JSON_STRING:
         result += "\"";
-        result += m_value;
+        escapeString(m_value, result);
         result += "\"";
         break;
     case JsonObject::JSON_ARRAY:
+        if (m_array.empty()) {
+            result += "[]";
+            break;
+        }
+
         result += "[";
         result += newLine;
         ++indent;
 
         for (auto it = m_array.begin(); it != m_array.end(); ++it)
         {
-            result += std::string(indent * spaces, ' ');
-            result += it->_stringify(indent, mode);
+            result.append(indent * spaces, ' ');
+            it->_stringify(result, indent, mode, useCache);
 
             if (it != m_array.end() - 1) {
                 result += ",";
@@ -308,11 +858,16 @@ std::string JsonObject::_stringify(size_t indent, StringifyMode mode)
 
         --indent;
         result += newLine;
-        result += std::string(indent * spaces, ' ');
+        result.append(indent * spaces, ' ');
         result += "]";
 
         break;
     case JsonObject::JSON_OBJECT: {
+        if (m_map.empty()) {
+            result += "{}";
+            break;
+        }
+
         result += "{";
         result += newLine;
         ++indent;
@@ -320,15 +875,15 @@ std::string JsonObject::_stringify(size_t indent, StringifyMode mode)
         size_t i = 0, last = m_map.size() - 1;
         for (auto it = m_map.begin(); it != m_map.end(); ++it, ++i)
         {
-            result += std::string(indent * spaces, ' ');
+            result.append(indent * spaces, ' ');
             result += "\"";
-            result += it->first;
+            escapeString(it->first, result);
             result += "\":";
 
             if (mode != MODE_COMPACT)
                 result += " ";
 
-            result += it->second._stringify(indent, mode);
+            it->second._stringify(result, indent, mode, useCache);
             if (i < last) {
                 result += ",";
                 result += newLine;
@@ -337,323 +892,838 @@ std::string JsonObject::_stringify(size_t indent, StringifyMode mode)
 
         --indent;
         result += newLine;
-        result += std::string(indent * spaces, ' ');
+        result.append(indent * spaces, ' ');
         result += "}";
         break;
     }
     default: break;
     }
 
-    return result;
+    if (useCache) {
+        if (!m_cache)
+            m_cache.reset(new StringifyCache());
+
+        StringifyCache::Text &cached = m_cache->text(mode);
+        cached.text.assign(result, begin, std::string::npos);
+        cached.indent = indent;
+        cached.valid = true;
+    }
 }
 
-size_t JsonObject::_parseObject(const char *data, size_t len, size_t &end, JsonObject &obj)
+void JsonObject::_detachChildren(std::vector<JsonObject> &pending)
 {
-    if (len < 2) {
-        obj.m_type = JsonObject::JSON_ERROR;
-        return 1;
-    }
+    for (auto &it: m_array)
+        if (!it.m_array.empty() || !it.m_map.empty())
+            pending.push_back(std::move(it));
 
-    size_t step = 0, errPos = 1;
-    char symbol = data[step];
-    std::string key, valueStr;
-    end = 0;
+    for (auto &it: m_map)
+        if (!it.second.m_array.empty() || !it.second.m_map.empty())
+            pending.push_back(std::move(it.second));
+}
 
-    if (symbol != '{') {
-        obj.m_type = JsonObject::JSON_ERROR;
-        return 1;
+void JsonObject::_reset(JsonObject::Type type)
+{
+    _invalidate();
+    m_type = type;
+    m_value.clear();
+
+    if (type != JsonObject::JSON_ARRAY)
+        m_array.clear();
+
+    if (type != JsonObject::JSON_OBJECT)
+        m_map.clear();
+}
+
+void JsonObject::_invalidate()
+{
+    m_id.value = nextContentId();
+
+    if (m_cache) {
+        for (auto &it: m_cache->modes) {
+            it.valid = false;
+            it.text.clear();
+        }
     }
+}
 
-    obj.m_type = JsonObject::JSON_OBJECT;
-    bool stepValue = false;
+void JsonObject::_invalidatePath(const std::string &path)
+{
+    // every container from the root down to the changed value becomes dirty
+    JsonObject *obj = this;
+    size_t start = 1;
+    std::string token;
+
+    while (obj) {
+        obj->_invalidate();
+        if (start > path.size())
+            break;
 
-    for (step = 1; step < len; ++step) {
-        symbol = data[step];
+        size_t pos = path.find('/', start);
+        if (pos == std::string::npos) pos = path.size();
 
-        if (stepValue) { // value parsing
-            if (symbol == 'n') { // null
-                errPos = _compareWord(data + step, len - step, "null");
-                if (errPos > 0 ) break;
+        token = decodePointerToken(path.data() + start, pos - start);
+        start = pos + 1;
 
-                step += 3;
-                obj.setValue(key, JsonObject());
-            }
-            else if (symbol == 't') { // true
-                errPos = _compareWord(data + step, len - step, "true");
-                if (errPos > 0 ) break;
+        JsonObject *next = nullptr;
+        if (obj->m_type == JsonObject::JSON_OBJECT) {
+            auto it = obj->m_map.find(token);
+            if (it != obj->m_map.end()) next = &it->second;
+        }
+        else if (obj->m_type == JsonObject::JSON_ARRAY) {
+            size_t index = 0;
+            if (pointerIndex(token, index) && index < obj->m_array.size())
+                next = &obj->m_array[index];
+        }
+        obj = next;
+    }
+}
 
-                step += 3;
-                obj.setValue(key, true);
-            }
-            else if (symbol == 'f') { // false
-                errPos = _compareWord(data + step, len - step, "false");
-                if (errPos > 0 ) break;
+void JsonObject::_assign(const JsonObject &value)
+{
+    // caching is a setting of the object itself, not a part of its content
+    bool cacheEnabled = m_cacheEnabled;
+    *this = value;
+    m_cacheEnabled = cacheEnabled;
+}
 
-                step += 4;
-                obj.setValue(key, false);
-            }
-            else if (symbol == '"') { // text
-                errPos = _parseText(data + step, len - step, end);
+void JsonObject::_releaseCache()
+{
+    m_cache.reset();
+
+    for (auto &it: m_array)
+        it._releaseCache();
+
+    for (auto &it: m_map)
+        it.second._releaseCache();
+}
+
+bool JsonObject::_parse(const char *data, size_t len, const ParseOptions &options, size_t &errPos)
+{
+    enum State {
+        STATE_VALUE,            // any value
+        STATE_VALUE_OR_CLOSE,   // first value of array or ']'
+        STATE_KEY_OR_CLOSE,     // first key of object or '}'
+        STATE_KEY,              // key after ','
+        STATE_COLON,            // ':' after key
+        STATE_NEXT,             // ',' or closing bracket after value
+        STATE_DONE              // only spaces are allowed
+    };
+
+    struct Frame {
+        JsonObject *obj;
+        size_t count;   // parsed elements of array
+        size_t stale;   // children of object left from the previous content
+    };
+
+    // open containers and key buffer, kept between calls to avoid allocations;
+    // pointers stay valid because a parent isn't changed while its child is open
+    static thread_local std::vector<Frame> stack;
+    static thread_local std::string key;
+    stack.clear();
+
+    if (!options.reuse)
+        clear();
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+    size_t pos = 0, end = 0;
+    State state = STATE_VALUE;
 
-                valueStr = std::string(data + step + 1, end - 1);
-                step += end;
+    auto closeContainer = [&]() {
+        Frame &frame = stack.back();
+        JsonObject *obj = frame.obj;
 
-                obj.setValue(key, valueStr);
+        if (obj->m_type == JsonObject::JSON_ARRAY) {
+            if (frame.count < obj->m_array.size())
+                obj->m_array.erase(obj->m_array.begin() + static_cast<std::ptrdiff_t>(frame.count), obj->m_array.end());
+        }
+        else if (frame.stale > 0) {
+            for (auto it = obj->m_map.begin(); it != obj->m_map.end();) {
+                if (it->second.m_type == JsonObject::JSON_ERROR) it = obj->m_map.erase(it);
+                else ++it;
             }
-            else if (isCharNumber(symbol)) { // number
+        }
 
-                errPos = _parseNumber(data + step, len - step, end);
+        stack.pop_back();
+    };
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+    while (true) {
+        pos = jsonSkipSpaces(data, len, pos);
 
-                valueStr = std::string(data + step, end);
-                step += end - 1;
+        if (pos == len) {
+            errPos = pos;
+            return state == STATE_DONE;
+        }
 
-                JsonObject jsonNum(valueStr);
-                jsonNum.m_type = JsonObject::JSON_NUMBER;
-                obj.m_map[key] = std::move(jsonNum);
-            }
-            else if (symbol == '{') { // object
-                JsonObject jsonObj;
-                errPos = _parseObject(data + step, len - step, end, jsonObj);
+        char symbol = data[pos];
+        bool valueEnd = false, failed = false;
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+        switch (state) {
+        case STATE_VALUE_OR_CLOSE:
+        case STATE_KEY_OR_CLOSE:
+            if (symbol == (state == STATE_VALUE_OR_CLOSE ? ']' : '}')) {
+                closeContainer();
+                ++pos;
+                valueEnd = true;
+                break;
+            }
 
-                step += end;
-                obj.m_map[key] = std::move(jsonObj);
+            if (state == STATE_KEY_OR_CLOSE) {
+                state = STATE_KEY;
+                continue;
             }
-            else if (symbol == '[') { // array
-                JsonObject jsonObj;
-                errPos = _parseArray(data + step, len - step, end, jsonObj);
+            // fall through
+        case STATE_VALUE: {
+            JsonObject *target = this;
+            if (!stack.empty()) {
+                Frame &frame = stack.back();
+                JsonObject *parent = frame.obj;
+
+                if (parent->m_type == JsonObject::JSON_ARRAY) {
+                    if (frame.count == parent->m_array.size())
+                        parent->m_array.emplace_back();
+                    target = &parent->m_array[frame.count++];
+                }
+                else {
+                    auto it = parent->m_map.find(key);
+                    if (it == parent->m_map.end())
+                        it = parent->m_map.emplace(key, JsonObject()).first;
+                    else if (!options.reuse)
+                        it->second.clear(); // repeated key
+                    target = &it->second;
+                }
+            }
+
+            if (symbol == '{' || symbol == '[') {
+                if (options.maxDepth > 0 && stack.size() == options.maxDepth) {
+                    failed = true;
+                    break;
+                }
+
+                target->_reset(symbol == '{' ? JsonObject::JSON_OBJECT : JsonObject::JSON_ARRAY);
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+                // children left from the previous content are marked and removed
+                // on closing if they don't appear in the new text
+                for (auto &it: target->m_map)
+                    it.second.m_type = JsonObject::JSON_ERROR;
 
-                step += end;
-                obj.m_map[key] = std::move(jsonObj);
+                stack.push_back({target, 0, target->m_map.size()});
+                state = symbol == '{' ? STATE_KEY_OR_CLOSE : STATE_VALUE_OR_CLOSE;
+                ++pos;
             }
-            else if (symbol == ',') {
-                stepValue = false;
+            else if (symbol == '"') {
+                target->_reset(JsonObject::JSON_STRING);
+                failed = _parseText(data + pos, len - pos, end) > 0 ||
+                         !unescapeString(data + pos + 1, end - 1, target->m_value);
+                if (failed) break;
+
+                pos += end + 1;
+                valueEnd = true;
             }
-            else if (symbol == '}') {
-                break;
+            else if (isCharNumber(symbol)) {
+                target->_reset(JsonObject::JSON_NUMBER);
+                _parseNumber(data + pos, len - pos, end);
+                target->m_value.assign(data + pos, end);
+                pos += end;
+                valueEnd = true;
+            }
+            else if (symbol == 't' || symbol == 'f') {
+                const char *word = symbol == 't' ? "true" : "false";
+                size_t wordErr = _compareWord(data + pos, len - pos, word);
+                if (wordErr > 0) {
+                    pos += wordErr - 1;
+                    failed = true;
+                    break;
+                }
+
+                target->_reset(JsonObject::JSON_BOOL);
+                target->m_value = word;
+                pos += strlen(word);
+                valueEnd = true;
+            }
+            else if (symbol == 'n') {
+                size_t wordErr = _compareWord(data + pos, len - pos, "null");
+                if (wordErr > 0) {
+                    pos += wordErr - 1;
+                    failed = true;
+                    break;
+                }
+
+                target->_reset(JsonObject::JSON_NULL);
+                pos += 4;
+                valueEnd = true;
             }
+            else failed = true;
+            break;
         }
-        else { // key parsing
-            if (symbol == '"') {
-                errPos = _parseText(data + step, len - step, end);
-
-                if (errPos > 0) break;
-                if (end == 0) break;
+        case STATE_KEY:
+            if (symbol == '"' && _parseText(data + pos, len - pos, end) == 0) {
+                key.clear();
+                if (!unescapeString(data + pos + 1, end - 1, key)) {
+                    failed = true;
+                    break;
+                }
+
+                pos += end + 1;
+                state = STATE_COLON;
+            }
+            else failed = true;
+            break;
+        case STATE_COLON:
+            if (symbol == ':') {
+                ++pos;
+                state = STATE_VALUE;
+            }
+            else failed = true;
+            break;
+        case STATE_NEXT: {
+            bool isObject = stack.back().obj->m_type == JsonObject::JSON_OBJECT;
 
-                key = std::string(data + step + 1, end - 1);
-                step += end;
+            if (symbol == ',') {
+                ++pos;
+                state = isObject ? STATE_KEY : STATE_VALUE;
             }
-            else if (symbol == ':') {
-                stepValue = true;
+            else if (symbol == (isObject ? '}' : ']')) {
+                closeContainer();
+                ++pos;
+                valueEnd = true;
             }
+            else failed = true;
+            break;
+        }
+        case STATE_DONE:
+            failed = true;
+            break;
         }
-    }
 
-    if (errPos == 0) {
-        end = step;
-        return 0;
+        if (failed) {
+            errPos = pos;
+            return false;
+        }
+
+        if (valueEnd)
+            state = stack.empty() ? STATE_DONE : STATE_NEXT;
     }
-    else obj.m_type = JsonObject::JSON_ERROR;
-    return errPos + step;
 }
 
-size_t JsonObject::_parseArray(const char *data, size_t len, size_t &end, JsonObject &obj)
+size_t JsonObject::_parseText(const char *data, size_t len, size_t &end)
 {
-    if (len < 2) {
-        obj.m_type = JsonObject::JSON_ERROR;
-        return 1;
-    }
+    if (len < 2 || data[0] != '"') return 1;
 
-    size_t step = 0, errPos = 1;
-    char symbol = data[step];
-    std::string valueStr;
     end = 0;
+    size_t step = 1;
+
+    while (step < len) {
+        // skip 8 bytes at once while there are no quotes and backslashes
+        if (step + 8 <= len) {
+            uint64_t word = swarLoad(data + step);
+            uint64_t mask = swarEqualBytes(word, '"') | swarEqualBytes(word, '\\');
+            if (!mask) {
+                step += 8;
+                continue;
+            }
+            step += swarFirstByte(mask);
+        }
 
-    if (symbol != '[') {
-        obj.m_type = JsonObject::JSON_ERROR;
-        return 1;
+        char symbol = data[step];
+        if (symbol == '"') {
+            end = step;
+            return 0;
+        }
+        else if (symbol == '\\') {
+            step += 2;
+        }
+        else ++step;
     }
 
-    obj.m_type = JsonObject::JSON_ARRAY;
-    bool stepValue = true;
+    return len;
+}
 
-    for (step = 1; step < len; ++step) {
-        symbol = data[step];
+size_t JsonObject::_parseNumber(const char *data, size_t len, size_t &end)
+{
+    end = 0;
+    while (end < len && isCharNumber(data[end]))
+        ++end;
 
-        if (stepValue) { // value parsing
+    return end > 0 ? 0 : 1;
+}
 
-            if (symbol == 'n') { // null
-                errPos = _compareWord(data + step, len - step, "null");
-                stepValue = false;
-                if (errPos > 0 ) break;
+size_t JsonObject::_compareWord(const char *data, size_t len, const char* word)
+{
+    size_t size = strlen(word);
 
-                step += 3;
-                obj.m_array.push_back(JsonObject());
-            }
-            else if (symbol == 't') { // true
-                errPos = _compareWord(data + step, len - step, "true");
-                stepValue = false;
-                if (errPos > 0 ) break;
+    for (size_t i = 0; i < size; ++i) {
+        if (i == len || data[i] != word[i])
+            return i + 1;
+    }
 
-                step += 3;
-                obj.m_array.push_back(true);
-            }
-            else if (symbol == 'f') { // false
-                errPos = _compareWord(data + step, len - step, "false");
-                stepValue = false;
-                if (errPos > 0 ) break;
+    return 0;
+}
 
-                step += 4;
-                obj.m_array.push_back(false);
-            }
-            else if (symbol == '"') { // text
-                errPos = _parseText(data + step, len - step, end);
-                stepValue = false;
+bool JsonObject::isCharNumber(char symbol)
+{
+    return (symbol >= '0' && symbol <= '9') || symbol == '-' || symbol == '+' ||
+           symbol == '.' || symbol == 'e' || symbol == 'E';
+}
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+bool JsonObject::operator==(const JsonObject &other) const
+{
+    if (m_type != other.m_type)
+        return false;
 
-                valueStr = std::string(data + step + 1, end - 1);
-                step += end;
+    if (m_id.value != 0 && m_id.value == other.m_id.value)
+        return true;
 
-                obj.m_array.push_back(valueStr);
-            }
-            else if (isCharNumber(symbol)) { // number
+    switch (m_type) {
+    case JsonObject::JSON_ARRAY:
+        return m_array == other.m_array;
+    case JsonObject::JSON_OBJECT:
+        return m_map == other.m_map;
+    case JsonObject::JSON_NUMBER:
+        // same value may be written differently: 1, 1.0, 1e0
+        return m_value == other.m_value ||
+               std::strtod(m_value.c_str(), nullptr) == std::strtod(other.m_value.c_str(), nullptr);
+    default:
+        return m_value == other.m_value;
+    }
+}
 
-                errPos = _parseNumber(data + step, len - step, end);
-                stepValue = false;
+bool JsonObject::operator!=(const JsonObject &other) const
+{
+    return !(*this == other);
+}
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+JsonObject JsonObject::diff(const JsonObject &from, const JsonObject &to)
+{
+    JsonObject patch(std::vector<JsonObject>{});
+    std::string path;
+    _diff(from, to, path, patch);
+    return patch;
+}
 
-                valueStr = std::string(data + step, end);
-                step += end - 1;
+size_t JsonObject::applyPatch(const JsonObject &patch)
+{
+    if (patch.m_type != JsonObject::JSON_ARRAY)
+        return 1;
 
-                JsonObject jsonNum(valueStr);
-                jsonNum.m_type = JsonObject::JSON_NUMBER;
-                obj.m_array.push_back(std::move(jsonNum));
-            }
-            else if (symbol == '{') { // object
-                JsonObject jsonObj;
-                errPos = _parseObject(data + step, len - step, end, jsonObj);
-                stepValue = false;
+    for (size_t i = 0; i < patch.m_array.size(); ++i) {
+        const JsonObject &operation = patch.m_array[i];
+        if (operation.m_type != JsonObject::JSON_OBJECT)
+            return i + 1;
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+        auto opIt = operation.m_map.find("op");
+        auto pathIt = operation.m_map.find("path");
+        auto valueIt = operation.m_map.find("value");
+        auto fromIt = operation.m_map.find("from");
 
-                step += end;
-                obj.m_array.push_back(std::move(jsonObj));
-            }
-            else if (symbol == '[') { // array
-                JsonObject jsonArr;
-                errPos = _parseArray(data + step, len - step, end, jsonArr);
+        // text of other types is empty and would point to the whole document
+        if (opIt == operation.m_map.end() || opIt->second.m_type != JsonObject::JSON_STRING ||
+            pathIt == operation.m_map.end() || pathIt->second.m_type != JsonObject::JSON_STRING)
+            return i + 1;
+
+        const std::string &op = opIt->second.m_value;
+        const std::string &path = pathIt->second.m_value;
+        bool hasValue = valueIt != operation.m_map.end();
+        bool hasFrom = fromIt != operation.m_map.end();
 
-                if (errPos > 0) break;
-                if (end == 0) break;
+        if (hasFrom && fromIt->second.m_type != JsonObject::JSON_STRING)
+            return i + 1;
+        bool success = false;
 
-                step += end;
-                obj.m_array.push_back(std::move(jsonArr));
+        if (op == "add" && hasValue) {
+            success = _patchAdd(path, valueIt->second);
+        }
+        else if (op == "remove") {
+            success = _patchRemove(path);
+        }
+        else if (op == "replace" && hasValue) {
+            JsonObject *target = _find(path);
+            if (target) {
+                target->_assign(valueIt->second);
+                success = true;
             }
         }
-        if (symbol == ',') {
-            stepValue = true;
+        else if (op == "move" && hasFrom) {
+            const std::string &from = fromIt->second.m_value;
+            // a value can't be moved into one of its own children
+            if (path.compare(0, from.size(), from) == 0 && path.size() > from.size() && path[from.size()] == '/') {
+                success = false;
+            }
+            else {
+                JsonObject value;
+                if (_patchRemove(from, &value)) {
+                    _invalidatePath(from);
+                    success = _patchAdd(path, value);
+                }
+            }
         }
-        else if (symbol == ']') {
-            break;
+        else if (op == "copy" && hasFrom) {
+            JsonObject *source = _find(fromIt->second.m_value);
+            if (source) {
+                JsonObject value = *source;
+                success = _patchAdd(path, value);
+            }
         }
+        else if (op == "test" && hasValue) {
+            JsonObject *target = _find(path);
+            success = target && *target == valueIt->second;
+        }
+
+        if (!success)
+            return i + 1;
+
+        // walking stops where the path no longer exists, e.g. after "remove"
+        if (op != "test")
+            _invalidatePath(path);
     }
 
-    if (errPos == 0) {
-        end = step;
-        return 0;
+    return 0;
+}
+
+void JsonObject::mergePatch(const JsonObject &patch)
+{
+    if (patch.m_type != JsonObject::JSON_OBJECT) {
+        _assign(patch);
+        return;
+    }
+
+    if (m_type != JsonObject::JSON_OBJECT) {
+        clear();
+        m_type = JsonObject::JSON_OBJECT;
+    }
+
+    _invalidate();
+    for (auto &it: patch.m_map) {
+        if (it.second.m_type == JsonObject::JSON_NULL)
+            m_map.erase(it.first);
+        else m_map[it.first].mergePatch(it.second);
     }
-    else obj.m_type = JsonObject::JSON_ERROR;
-    return errPos + step;
 }
 
-size_t JsonObject::_parseText(const char *data, size_t len, size_t &end)
+void JsonObject::_diff(const JsonObject &from, const JsonObject &to, std::string &path, JsonObject &patch)
 {
-    if (len < 3) return 1;
+    // same object or an unchanged copy of it
+    if (&from == &to || (from.m_id.value != 0 && from.m_id.value == to.m_id.value))
+        return;
 
-    end = 0;
-    size_t step = 0;
-    bool started = false;
+    if (from.m_type != to.m_type ||
+        (from.m_type != JsonObject::JSON_ARRAY && from.m_type != JsonObject::JSON_OBJECT)) {
 
-    for (step = 0; step < len; ++step) {
-        if (data[step] == '"' && data[step-1] != '\\') {
-            if (started) {
-                end = step;
-                return 0;
-            }
-            else {
-                started = true;
-            }
+        if (from == to)
+            return;
+
+        _diffOperation(patch, "replace", path, &to);
+        return;
+    }
+
+    // 'path' is shared by the whole walk, every level appends its token and restores it
+    size_t pathSize = path.size();
+
+    if (from.m_type == JsonObject::JSON_ARRAY) {
+        size_t common = std::min(from.m_array.size(), to.m_array.size());
+
+        for (size_t i = 0; i < common; ++i) {
+            path += '/';
+            path += std::to_string(i);
+            _diff(from.m_array[i], to.m_array[i], path, patch);
+            path.resize(pathSize);
         }
+
+        // remove from the end, so the indexes of remaining elements stay valid
+        for (size_t i = from.m_array.size(); i > common; --i) {
+            path += '/';
+            path += std::to_string(i - 1);
+            _diffOperation(patch, "remove", path, nullptr);
+            path.resize(pathSize);
+        }
+
+        for (size_t i = common; i < to.m_array.size(); ++i) {
+            path += '/';
+            path += std::to_string(i);
+            _diffOperation(patch, "add", path, &to.m_array[i]);
+            path.resize(pathSize);
+        }
+        return;
     }
 
-    return step;
-}
+    // both maps are sorted, so walk them side by side
+    auto fromIt = from.m_map.begin();
+    auto toIt = to.m_map.begin();
 
-size_t JsonObject::_parseNumber(const char *data, size_t len, size_t &end)
-{
-    if (len < 2) return 1;
+    while (fromIt != from.m_map.end() || toIt != to.m_map.end()) {
+        int cmp = 0;
+        if (fromIt == from.m_map.end()) cmp = 1;
+        else if (toIt == to.m_map.end()) cmp = -1;
+        else cmp = fromIt->first.compare(toIt->first);
 
-    end = 0;
+        path += '/';
+        appendPointerToken(cmp > 0 ? toIt->first : fromIt->first, path);
 
-    for (int i = 0; i < len; ++i) {
-        char symbol = data[i];
-        if (isCharNumber(symbol)) {
-            continue;
+        if (cmp < 0) {
+            _diffOperation(patch, "remove", path, nullptr);
+            ++fromIt;
         }
-        else if (symbol == ' ' || symbol == ',' ||
-                 symbol == '\r' || symbol == '\n') {
-            end = i;
-            return 0;
+        else if (cmp > 0) {
+            _diffOperation(patch, "add", path, &toIt->second);
+            ++toIt;
         }
         else {
-            end = i;
-            break;
+            _diff(fromIt->second, toIt->second, path, patch);
+            ++fromIt;
+            ++toIt;
         }
+
+        path.resize(pathSize);
     }
+}
+
+void JsonObject::_diffOperation(JsonObject &patch, const char *op, const std::string &path, const JsonObject *value)
+{
+    JsonObject operation;
+    operation.m_type = JsonObject::JSON_OBJECT;
+    operation.m_map.emplace("op", op);
+    operation.m_map.emplace("path", path);
 
-    return end + 1;
+    if (value)
+        operation.m_map.emplace("value", *value);
+
+    patch.m_array.push_back(std::move(operation));
 }
 
-size_t JsonObject::_compareWord(const char *data, size_t len, const char* word)
+JsonObject *JsonObject::_pointer(const std::string &path, std::string &token)
 {
-    size_t size = strlen(word);
-    if (len < size) return 1;
+    if (path.empty() || path[0] != '/')
+        return nullptr;
 
-    for (int i = 0; i < size; ++i) {
-        if (data[i] != word[i])
-            return i + 1;
+    JsonObject *obj = this;
+    size_t start = 1;
+
+    while (true) {
+        size_t pos = path.find('/', start);
+        if (pos == std::string::npos) pos = path.size();
+
+        token = decodePointerToken(path.data() + start, pos - start);
+        if (pos == path.size())
+            return obj;
+
+        if (obj->m_type == JsonObject::JSON_OBJECT) {
+            auto it = obj->m_map.find(token);
+            if (it == obj->m_map.end()) return nullptr;
+            obj = &it->second;
+        }
+        else if (obj->m_type == JsonObject::JSON_ARRAY) {
+            size_t index = 0;
+            if (!pointerIndex(token, index) || index >= obj->m_array.size()) return nullptr;
+            obj = &obj->m_array[index];
+        }
+        else return nullptr;
+
+        start = pos + 1;
     }
+}
 
-    char lastSymbol = data[size];
+JsonObject *JsonObject::_find(const std::string &path)
+{
+    if (path.empty())
+        return this;
 
-    if (lastSymbol == ' ' || lastSymbol == ',' ||
-         lastSymbol == '\r' || lastSymbol == '\n') {
-        return 0;
+    std::string token;
+    JsonObject *parent = _pointer(path, token);
+    if (!parent)
+        return nullptr;
+
+    if (parent->m_type == JsonObject::JSON_OBJECT) {
+        auto it = parent->m_map.find(token);
+        return it != parent->m_map.end() ? &it->second : nullptr;
+    }
+    else if (parent->m_type == JsonObject::JSON_ARRAY) {
+        size_t index = 0;
+        if (pointerIndex(token, index) && index < parent->m_array.size())
+            return &parent->m_array[index];
     }
-    else return size;
+
+    return nullptr;
 }
 
-bool JsonObject::isCharNumber(char symbol)
+bool JsonObject::_patchAdd(const std::string &path, const JsonObject &value)
 {
-    for (int i=0; i<15; ++i)
-        if (NUM_SYMBOLS[i] == symbol)
-            return true;
+    if (path.empty()) {
+        _assign(value);
+        return true;
+    }
+
+    std::string token;
+    JsonObject *parent = _pointer(path, token);
+    if (!parent)
+        return false;
+
+    if (parent->m_type == JsonObject::JSON_OBJECT) {
+        parent->m_map[token] = value;
+        return true;
+    }
+    else if (parent->m_type == JsonObject::JSON_ARRAY) {
+        size_t index = parent->m_array.size();
+        if (token != "-" && (!pointerIndex(token, index) || index > parent->m_array.size()))
+            return false;
+
+        parent->m_array.insert(parent->m_array.begin() + static_cast<std::ptrdiff_t>(index), value);
+        return true;
+    }
 
     return false;
 }
+
+bool JsonObject::_patchRemove(const std::string &path, JsonObject *removed)
+{
+    std::string token;
+    JsonObject *parent = _pointer(path, token);
+    if (!parent)
+        return false;
+
+    if (parent->m_type == JsonObject::JSON_OBJECT) {
+        auto it = parent->m_map.find(token);
+        if (it == parent->m_map.end()) return false;
+
+        if (removed) *removed = std::move(it->second);
+        parent->m_map.erase(it);
+        return true;
+    }
+    else if (parent->m_type == JsonObject::JSON_ARRAY) {
+        size_t index = 0;
+        if (!pointerIndex(token, index) || index >= parent->m_array.size()) return false;
+
+        if (removed) *removed = std::move(parent->m_array[index]);
+        parent->m_array.erase(parent->m_array.begin() + static_cast<std::ptrdiff_t>(index));
+        return true;
+    }
+
+    return false;
+}
+
+void JsonObject::extractColumns(std::vector<Column> &columns, size_t threads) const
+{
+    size_t rows = m_type == JsonObject::JSON_ARRAY ? m_array.size() : 0;
+
+    // split paths once, plain keys are taken as a single token
+    std::vector<std::vector<std::string>> paths(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        Column &column = columns[i];
+        const std::string &path = column.path;
+
+        if (!path.empty() && path[0] == '/') {
+            size_t start = 1;
+            while (true) {
+                size_t pos = path.find('/', start);
+                if (pos == std::string::npos) pos = path.size();
+
+                paths[i].push_back(decodePointerToken(path.data() + start, pos - start));
+                if (pos == path.size()) break;
+                start = pos + 1;
+            }
+        }
+        else if (!path.empty()) {
+            paths[i].push_back(path);
+        }
+
+        column.numbers.clear();
+        column.integers.clear();
+        column.strings.clear();
+
+        if (column.type == COLUMN_NUMBER) column.numbers.resize(rows);
+        else if (column.type == COLUMN_INTEGER) column.integers.resize(rows);
+        else column.strings.resize(rows);
+
+        column.nulls.assign(rows, 0);
+    }
+
+    // every thread writes its own range of rows of the preallocated columns
+    auto extract = [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                Column &column = columns[i];
+                const JsonObject *field = m_array[row]._lookup(paths[i]);
+
+                if (column.type == COLUMN_STRING) {
+                    if (field && field->m_type == JsonObject::JSON_STRING)
+                        column.strings[row] = field->m_value;
+                    else column.nulls[row] = 1;
+                    continue;
+                }
+
+                if (!field || field->m_type != JsonObject::JSON_NUMBER) {
+                    column.nulls[row] = 1;
+                    continue;
+                }
+
+                if (column.type == COLUMN_INTEGER) {
+                    const char *first = field->m_value.data();
+                    const char *last = first + field->m_value.size();
+
+                    int64_t value = 0;
+                    auto result = std::from_chars(first, last, value);
+
+                    // numbers like "5.0000000000" written by JsonObject(double)
+                    if (result.ec != std::errc() || result.ptr != last) {
+                        double number = 0.;
+                        bool valid = numberValue(field->m_value, number) &&
+                                     number >= -9223372036854775808.0 && number < 9223372036854775808.0;
+                        value = valid ? static_cast<int64_t>(number) : 0;
+
+                        if (!valid || static_cast<double>(value) != number) {
+                            column.nulls[row] = 1;
+                            continue;
+                        }
+                    }
+
+                    column.integers[row] = value;
+                }
+                else if (!numberValue(field->m_value, column.numbers[row])) {
+                    column.nulls[row] = 1;
+                }
+            }
+        }
+    };
+
+    threads = std::min(threads, rows);
+    if (threads <= 1) {
+        extract(0, rows);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    // started threads use 'columns', so they are joined even if the next one fails to start
+    try {
+        size_t chunk = (rows + threads - 1) / threads;
+        for (size_t begin = 0; begin < rows; begin += chunk)
+            workers.emplace_back(extract, begin, std::min(begin + chunk, rows));
+    }
+    catch (...) {
+        for (auto &it: workers)
+            it.join();
+        throw;
+    }
+
+    for (auto &it: workers)
+        it.join();
+}
+
+const JsonObject *JsonObject::_lookup(const std::vector<std::string> &tokens) const
+{
+    const JsonObject *obj = this;
+
+    for (auto &token: tokens) {
+        if (obj->m_type == JsonObject::JSON_OBJECT) {
+            auto it = obj->m_map.find(token);
+            if (it == obj->m_map.end()) return nullptr;
+            obj = &it->second;
+        }
+        else if (obj->m_type == JsonObject::JSON_ARRAY) {
+            size_t index = 0;
+            if (!pointerIndex(token, index) || index >= obj->m_array.size()) return nullptr;
+            obj = &obj->m_array[index];
+        }
+        else return nullptr;
+    }
+
+    return obj;
+}
@@ -23,8 +23,11 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <cstdint>
 
 /// \brief The JsonObject class implements serialization and
 /// deserialization of JSON-formatted text.
@@ -53,6 +56,47 @@ public:
         MODE_4_SPACES = 4   /// 4 spaces indent and new lines
     };
 
+    /// \brief The ValidateError enum describes the reason of validation failure
+    enum ValidateError
+    {
+        VALID = 0,                  /// text is well-formed JSON
+        ERROR_UNEXPECTED_END,       /// text ends before the value is complete
+        ERROR_UNEXPECTED_SYMBOL,    /// symbol is not allowed at this position
+        ERROR_INVALID_STRING,       /// control character or bad escape sequence in string
+        ERROR_INVALID_NUMBER,       /// number doesn't match JSON number grammar
+        ERROR_INVALID_UTF8,         /// malformed UTF-8 sequence in string
+        ERROR_TOO_DEEP              /// nesting exceeds validator limit
+    };
+
+    /// \brief The ParseOptions struct describes additional parsing settings
+    struct ParseOptions
+    {
+        bool strict = false;    /// check grammar and UTF-8 with validate() before parsing
+        size_t maxDepth = 4096; /// maximum nesting of arrays and objects, 0 - unlimited
+                                /// copying, stringify(), comparison and diff() are recursive,
+                                /// so deeper objects may overflow the stack
+        bool reuse = false;     /// overwrite existing content in place keeping its memory
+    };
+
+    /// \brief The ColumnType enum describes type of values extracted by extractColumns()
+    enum ColumnType
+    {
+        COLUMN_NUMBER,      /// double values of JSON_NUMBER
+        COLUMN_INTEGER,     /// int64_t values of JSON_NUMBER
+        COLUMN_STRING       /// text of JSON_STRING
+    };
+
+    /// \brief The Column struct describes one field taken from every element of an array
+    struct Column
+    {
+        std::string path;                       /// JSON Pointer inside element, e.g. "/user/age", or a plain key
+        JsonObject::ColumnType type = COLUMN_NUMBER;
+        std::vector<double> numbers;            /// values if type is COLUMN_NUMBER
+        std::vector<int64_t> integers;          /// values if type is COLUMN_INTEGER
+        std::vector<std::string_view> strings;  /// values if type is COLUMN_STRING, valid while the source is unchanged
+        std::vector<uint8_t> nulls;             /// 1 if field is missing, 'null' or doesn't match the type
+    };
+
     /// \brief JsonObject Creates an object with the appropriate content:
     JsonObject();                                       /// 'null' content
     JsonObject(bool value);                             /// 'true' or 'false'
@@ -64,6 +108,14 @@ public:
     JsonObject(const std::vector<JsonObject> &value);   /// array of JsonObjects
     JsonObject(std::vector<JsonObject> &&value);        /// array of JsonObjects
 
+    JsonObject(const JsonObject &other) = default;
+    JsonObject(JsonObject &&other) = default;
+    JsonObject &operator=(const JsonObject &other) = default;
+    JsonObject &operator=(JsonObject &&other) = default;
+
+    /// \brief ~JsonObject - releases nested containers without recursion
+    ~JsonObject();
+
     /// \brief parse - Converts text to JsonObject
     /// \param data - pinter to the beginning of the text array
     /// \param len - text size
@@ -75,24 +127,56 @@ public:
     /// \return returns 0 if success, otherwise parsing error character index
     size_t parse(const std::string &data);
 
+    /// \brief reparse - Converts text to JsonObject reusing memory of the current content
+    /// nodes, strings and containers are overwritten in place, so parsing messages
+    /// of the same shape again and again almost doesn't allocate
+    /// \param data - pinter to the beginning of the text array
+    /// \param len - text size
+    /// \return returns 0 if success, otherwise parsing error character index
+    size_t reparse(const char *data, size_t len);
+    size_t reparse(const std::string &data);
+
+    /// \brief parse - Converts text to JsonObject with given options
+    /// \param data - pinter to the beginning of the text array
+    /// \param len - text size
+    /// \param options - ParseOptions describes additional parsing settings
+    /// \return returns 0 if success, otherwise parsing error character index
+    size_t parse(const char *data, size_t len, const ParseOptions &options);
+
+    /// \brief validate - Checks JSON grammar and UTF-8 of strings without building objects
+    /// doesn't allocate memory, nesting is limited to 4096 levels
+    /// \param data - pinter to the beginning of the text array
+    /// \param len - text size
+    /// \param offset - receives index of the symbol where error was found
+    /// \return VALID if success, otherwise the reason of failure
+    static JsonObject::ValidateError validate(const char *data, size_t len, size_t &offset);
+    static JsonObject::ValidateError validate(const std::string &data, size_t &offset);
+
     /// \brief stringify - Converts JsonObject to text
     /// \param mode - StringifyMode describes text representation mode
     /// \return convertation result
     std::string stringify(JsonObject::StringifyMode mode = MODE_2_SPACES);
 
+    /// \brief setStringifyCache - enables caching of serialized containers
+    /// when enabled, stringify keeps text of every array and object for each mode separately
+    /// and reuses it for subtrees that were not changed since the previous call with that mode,
+    /// every level keeps the whole text of its subtree, so the cache takes about
+    /// depth * text size of memory for each mode in use, disabling releases all cached text
+    void setStringifyCache(bool enabled);
+
     /// \brief type - returns type of the content.
-    JsonObject::Type type();
+    JsonObject::Type type() const;
 
     /// \brief keys - returns array of keys if type is JSON_OBJECT
-    std::vector<std::string> keys();
+    std::vector<std::string> keys() const;
 
     /// \brief exist - returns 'true' if given key is exist in object
-    bool exist(const char* key);
-    bool exist(const std::string &key);
+    bool exist(const char* key) const;
+    bool exist(const std::string &key) const;
 
     /// \brief value - returns JsonObject if key exist, otherwise JsonObject with type JSON_NULL
-    JsonObject value(const char* key);
-    JsonObject value(const std::string &key);
+    JsonObject value(const char* key) const;
+    JsonObject value(const std::string &key) const;
 
     /// \brief setValue - add key-value pair to JsonObject
     /// convert oblect to JSON_OBJECT type if it's not, with loss of previous data
@@ -105,10 +189,10 @@ public:
 
     /// \brief at - returns JsonObject by index if type is JSON_ARRAY
     /// otherwise JsonObject with 'null'
-    JsonObject at(size_t index);
+    JsonObject at(size_t index) const;
 
     /// \brief size - returns the number of stored elements if type is JSON_OBJECT or JSON_ARRAY
-    size_t size();
+    size_t size() const;
 
     /// \brief clear - remove all contained data and set type to JSON_NULL
     void clear();
@@ -118,33 +202,120 @@ public:
     void remove(const std::string &key);
 
     /// \brief toBool - returns contained value if type is JSON_BOOL
-    bool toBool(bool defVal = false);
+    bool toBool(bool defVal = false) const;
 
     /// \brief toNumber - returns contained value if type is JSON_NUMBER
-    double toNumber(double defVal = 0.);
+    double toNumber(double defVal = 0.) const;
 
     /// \brief toNumber - returns contained value if type is JSON_STRING
-    std::string toString(const std::string defVal = "");
+    std::string toString(const std::string defVal = "") const;
 
     /// \brief toNumber - returns contained value if type is JSON_ARRAY
-    std::vector<JsonObject> toArray();
+    std::vector<JsonObject> toArray() const;
 
     /// \brief toMap - returns map container with all included objects
-    std::map<std::string, JsonObject> toMap();
+    std::map<std::string, JsonObject> toMap() const;
+
+    /// \brief operator== - returns 'true' if type and content of both objects are equal
+    /// numbers are compared by value, unchanged copies are equal at once
+    bool operator==(const JsonObject &other) const;
+    bool operator!=(const JsonObject &other) const;
+
+    /// \brief diff - Builds JSON Patch (RFC 6902) that converts one object to another
+    /// unchanged subtrees produce no operations, subtrees copied from each other and
+    /// not changed since are skipped without walking them
+    /// \param from - source object
+    /// \param to - target object
+    /// \return JSON_ARRAY of "add", "remove" and "replace" operations
+    static JsonObject diff(const JsonObject &from, const JsonObject &to);
+
+    /// \brief applyPatch - Applies JSON Patch (RFC 6902) to the object in place
+    /// operations before the failed one stay applied, an operation that isn't an object
+    /// or has "op", "path" or "from" other than a string fails
+    /// \param patch - JSON_ARRAY of operations
+    /// \return returns 0 if success, otherwise number of the failed operation starting from 1
+    size_t applyPatch(const JsonObject &patch);
+
+    /// \brief mergePatch - Applies JSON Merge Patch (RFC 7396) to the object in place
+    /// \param patch - values to set, 'null' values remove keys
+    void mergePatch(const JsonObject &patch);
+
+    /// \brief extractColumns - fills typed columns with fields of every element if type is JSON_ARRAY
+    /// all columns are filled in one pass over the elements
+    /// \param columns - path and type of each column are given, values and nulls are filled
+    /// \param threads - number of threads to split elements between
+    void extractColumns(std::vector<Column> &columns, size_t threads = 1) const;
 
 private:
     std::string m_value;
     std::vector<JsonObject> m_array;
 
     JsonObject::Type m_type = JsonObject::JSON_NULL;
+    bool m_cacheEnabled = false;
     std::map<std::string, JsonObject> m_map;
-    std::vector<std::string> m_keys;
 
-    std::string _stringify(size_t indent, JsonObject::StringifyMode mode);
-    size_t _parseObject(const char* data, size_t len, size_t &end, JsonObject& obj);
-    size_t _parseArray(const char* data, size_t len, size_t &end, JsonObject &obj);
+    /// \brief The StringifyCache struct keeps serialized text of a container for every mode
+    struct StringifyCache
+    {
+        struct Text
+        {
+            bool valid = false;
+            size_t indent = 0;
+            std::string text;
+        };
+
+        Text modes[3];  /// indexed by StringifyMode / 2
+
+        Text &text(JsonObject::StringifyMode mode) { return modes[mode / 2]; }
+    };
+
+    /// \brief The CachePtr class owns StringifyCache, copies of an object start without it
+    struct CachePtr : std::unique_ptr<StringifyCache>
+    {
+        CachePtr() = default;
+        CachePtr(const CachePtr &) : std::unique_ptr<StringifyCache>() {}
+        CachePtr(CachePtr &&) = default;
+        CachePtr &operator=(const CachePtr &) { reset(); return *this; }
+        CachePtr &operator=(CachePtr &&) = default;
+    };
+
+    CachePtr m_cache;   /// created only for containers when caching is enabled
+
+    /// \brief The ContentId struct identifies a state of the content, copies share it and
+    /// every change gives a new one, so equal ids mean equal subtrees, 0 - unknown
+    struct ContentId
+    {
+        uint64_t value = 0;
+
+        ContentId() = default;
+        ContentId(const ContentId &) = default;
+        ContentId(ContentId &&other) noexcept : value(other.value) { other.value = 0; }
+        ContentId &operator=(const ContentId &) = default;
+        ContentId &operator=(ContentId &&other) noexcept { value = other.value; other.value = 0; return *this; }
+    };
+
+    ContentId m_id;
+
+    void _stringify(std::string &result, size_t indent, JsonObject::StringifyMode mode, bool useCache);
+    void _reset(JsonObject::Type type);
+    void _invalidate();
+    void _invalidatePath(const std::string &path);
+    void _assign(const JsonObject &value);
+    void _detachChildren(std::vector<JsonObject> &pending);
+    void _releaseCache();
+    bool _parse(const char* data, size_t len, const ParseOptions &options, size_t &errPos);
     size_t _parseText(const char* data, size_t len, size_t &end);
     size_t _parseNumber(const char* data, size_t len, size_t &end);
     size_t _compareWord(const char *data, size_t len, const char* word);
     bool isCharNumber(char symbol);
+
+    static void _diff(const JsonObject &from, const JsonObject &to, std::string &path, JsonObject &patch);
+    static void _diffOperation(JsonObject &patch, const char *op, const std::string &path, const JsonObject *value);
+    JsonObject* _pointer(const std::string &path, std::string &token);
+    JsonObject* _find(const std::string &path);
+    const JsonObject* _lookup(const std::vector<std::string> &tokens) const;
+    bool _patchAdd(const std::string &path, const JsonObject &value);
+    bool _patchRemove(const std::string &path, JsonObject *removed = nullptr);
+
+    friend class FrozenJson;
 };
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+// Internal helpers for scanning text 8 bytes at once (SWAR), see "Bit Twiddling Hacks".
+// Masks have the high bit set in every byte that matches.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+static const uint64_t SWAR_ONES = 0x0101010101010101ULL;
+static const uint64_t SWAR_HIGHS = 0x8080808080808080ULL;
+
+static inline uint64_t swarLoad(const char *data)
+{
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+/// \brief swarZeroBytes - marks zero bytes of the word
+static inline uint64_t swarZeroBytes(uint64_t word)
+{
+    return ~(((word & ~SWAR_HIGHS) + ~SWAR_HIGHS) | word) & SWAR_HIGHS;
+}
+
+/// \brief swarEqualBytes - marks bytes equal to 'value'
+static inline uint64_t swarEqualBytes(uint64_t word, uint8_t value)
+{
+    return swarZeroBytes(word ^ (SWAR_ONES * value));
+}
+
+/// \brief swarControlBytes - marks bytes less than 0x20
+static inline uint64_t swarControlBytes(uint64_t word)
+{
+    return swarZeroBytes(word & (SWAR_ONES * 0xE0));
+}
+
+/// \brief swarSpecialBytes - marks quotes, backslashes and control characters
+static inline uint64_t swarSpecialBytes(uint64_t word)
+{
+    return swarEqualBytes(word, '"') | swarEqualBytes(word, '\\') | swarControlBytes(word);
+}
+
+/// \brief swarSpaceBytes - marks JSON whitespace: space, tab, CR and LF
+static inline uint64_t swarSpaceBytes(uint64_t word)
+{
+    return swarEqualBytes(word, ' ') | swarEqualBytes(word, '\n') |
+           swarEqualBytes(word, '\r') | swarEqualBytes(word, '\t');
+}
+
+/// \brief swarFirstByte - returns position of the first marked byte in memory order
+static inline size_t swarFirstByte(uint64_t mask)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    size_t index = 0;
+    while (!(mask & (0x80ULL << 56))) {
+        mask <<= 8;
+        ++index;
+    }
+    return index;
+#elif defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_ctzll(mask)) / 8;
+#else
+    size_t index = 0;
+    while (!(mask & 0x80)) {
+        mask >>= 8;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+static inline bool jsonIsSpace(char symbol)
+{
+    return symbol == ' ' || symbol == '\n' || symbol == '\r' || symbol == '\t';
+}
+
+/// \brief jsonSkipSpaces - returns position of the first non-whitespace symbol starting from 'pos'
+static inline size_t jsonSkipSpaces(const char *data, size_t len, size_t pos)
+{
+    // most tokens are not preceded by spaces, everything above ' ' is not a space
+    if (pos < len && static_cast<unsigned char>(data[pos]) > ' ')
+        return pos;
+
+    while (pos + 8 <= len) {
+        uint64_t other = ~swarSpaceBytes(swarLoad(data + pos)) & SWAR_HIGHS;
+        if (other)
+            return pos + swarFirstByte(other);
+        pos += 8;
+    }
+
+    while (pos < len && jsonIsSpace(data[pos]))
+        ++pos;
+
+    return pos;
+}
@@ -3,6 +3,7 @@
 #include <fstream>
 #include <sstream>
 #include "jsonobject.h"
+#include "frozenjson.h"
 
 using namespace std;
 
@@ -62,6 +63,10 @@ int main()
                 // get value
                 cout << "name: " << iObj.value("name").toString() << endl;
             }
+
+            // immutable copy for concurrent lookups
+            FrozenJson frozen(jsonObject);
+            cout << "frozen name: " << frozen.root().at(1).value("name").toString() << endl;
         }
     }
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <iostream>
+#include "jsonobject.h"
+
+using namespace std;
+
+static JsonObject fromText(const string &text)
+{
+    JsonObject result;
+    result.parse(text);
+    return result;
+}
+
+// applies 'patch' to a copy of 'document' and checks the result and the document after it
+static bool check(const string &document, const string &patch, size_t expected, const string &after)
+{
+    JsonObject target = fromText(document);
+    size_t result = target.applyPatch(fromText(patch));
+
+    if (result != expected || target != fromText(after)) {
+        cerr << "applyPatch(" << patch << ") returned " << result << ", expected " << expected
+             << ", document: " << target.stringify(JsonObject::MODE_COMPACT) << endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    const string document = "{\"a\":{\"b\":1},\"c\":[1,2]}";
+    bool success = true;
+
+    // well-formed operations
+    success &= check(document, "[{\"op\":\"add\",\"path\":\"/c/-\",\"value\":3}]", 0,
+                     "{\"a\":{\"b\":1},\"c\":[1,2,3]}");
+    success &= check(document, "[{\"op\":\"remove\",\"path\":\"/a/b\"}]", 0,
+                     "{\"a\":{},\"c\":[1,2]}");
+    success &= check(document, "[{\"op\":\"replace\",\"path\":\"/c/0\",\"value\":5}]", 0,
+                     "{\"a\":{\"b\":1},\"c\":[5,2]}");
+    success &= check(document, "[{\"op\":\"move\",\"from\":\"/a/b\",\"path\":\"/d\"}]", 0,
+                     "{\"a\":{},\"c\":[1,2],\"d\":1}");
+    success &= check(document, "[{\"op\":\"copy\",\"from\":\"/a\",\"path\":\"/d\"}]", 0,
+                     "{\"a\":{\"b\":1},\"c\":[1,2],\"d\":{\"b\":1}}");
+    success &= check(document, "[{\"op\":\"test\",\"path\":\"/a/b\",\"value\":1.0}]", 0, document);
+    success &= check(document, "[{\"op\":\"replace\",\"path\":\"\",\"value\":5}]", 0, "5");
+
+    // malformed operations fail and leave the document as is
+    success &= check(document, "{\"op\":\"remove\",\"path\":\"/a\"}", 1, document);
+    success &= check(document, "[5]", 1, document);
+    success &= check(document, "[[\"remove\",\"/a\"]]", 1, document);
+    success &= check(document, "[{\"path\":\"/a\"}]", 1, document);
+    success &= check(document, "[{\"op\":null,\"path\":\"/a\"}]", 1, document);
+    success &= check(document, "[{\"op\":\"remove\"}]", 1, document);
+    success &= check(document, "[{\"op\":\"replace\",\"path\":null,\"value\":5}]", 1, document);
+    success &= check(document, "[{\"op\":\"replace\",\"path\":0,\"value\":5}]", 1, document);
+    success &= check(document, "[{\"op\":\"add\",\"path\":[],\"value\":5}]", 1, document);
+    success &= check(document, "[{\"op\":\"copy\",\"from\":null,\"path\":\"/x\"}]", 1, document);
+    success &= check(document, "[{\"op\":\"move\",\"from\":{},\"path\":\"/x\"}]", 1, document);
+    success &= check(document, "[{\"op\":\"unknown\",\"path\":\"/a\"}]", 1, document);
+
+    // operations before the failed one stay applied
+    success &= check(document, "[{\"op\":\"remove\",\"path\":\"/c\"},{\"op\":\"remove\",\"path\":null}]", 2,
+                     "{\"a\":{\"b\":1}}");
+
+    // diff of two documents converts one into another
+    JsonObject from = fromText(document);
+    JsonObject to = fromText("{\"a\":{\"b\":2,\"e\":\"x\"},\"c\":[1],\"d\":null}");
+    JsonObject target = from;
+    if (target.applyPatch(JsonObject::diff(from, to)) != 0 || target != to) {
+        cerr << "diff() result doesn't convert source to target" << endl;
+        success = false;
+    }
+
+    // copies are skipped by diff() only while unchanged
+    auto checkChanged = [&](const char *name, const JsonObject &copy) {
+        JsonObject target = from;
+        if (copy == from || target.applyPatch(JsonObject::diff(from, copy)) != 0 || target != copy) {
+            cerr << "change by " << name << " is missed by diff()" << endl;
+            success = false;
+        }
+    };
+
+    JsonObject copy = from;
+    if (JsonObject::diff(from, copy).size() != 0) {
+        cerr << "diff() of equal copy isn't empty" << endl;
+        success = false;
+    }
+
+    copy.applyPatch(fromText("[{\"op\":\"replace\",\"path\":\"/a/b\",\"value\":2}]"));
+    checkChanged("applyPatch()", copy);
+
+    copy = from;
+    copy.mergePatch(fromText("{\"a\":{\"b\":null}}"));
+    checkChanged("mergePatch()", copy);
+
+    copy = from;
+    copy.reparse(string("{\"a\":{\"b\":1},\"c\":[1,3]}"));
+    checkChanged("reparse()", copy);
+
+    copy = from;
+    JsonObject moved = std::move(copy);
+    copy.setValue("a", moved.value("c"));
+    checkChanged("setValue()", copy);
+
+    if (!success)
+        return 1;
+
+    cout << "applyPatch: all operations checked" << endl;
+    return 0;
+}
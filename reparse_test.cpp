@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <new>
+#include "jsonobject.h"
+
+using namespace std;
+
+// counts every heap allocation of the process
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *data = malloc(size ? size : 1))
+        return data;
+    throw bad_alloc();
+}
+
+void operator delete(void *data) noexcept
+{
+    free(data);
+}
+
+void operator delete(void *data, size_t) noexcept
+{
+    free(data);
+}
+
+static string loadTestJson()
+{
+    string data = "[]";
+
+#ifdef TEST_JSON_PATH
+    std::ifstream jsonFile(TEST_JSON_PATH);
+    if(jsonFile) {
+        ostringstream ss;
+        ss << jsonFile.rdbuf();
+        data = ss.str();
+    }
+#endif
+
+    return data;
+}
+
+int main()
+{
+    // messages of the same shape with different values, like a feed of updates
+    string first = loadTestJson();
+    string second = first;
+    for (char &symbol : second) {
+        if (symbol >= '0' && symbol <= '8') ++symbol;
+    }
+
+    JsonObject message;
+    JsonObject expected;
+    const string *messages[] = { &first, &second };
+
+    // first passes grow nodes, buffers and the parser stack
+    for (const string *text : messages) {
+        if (message.reparse(*text) != 0) {
+            cerr << "reparse failed" << endl;
+            return 1;
+        }
+    }
+
+    size_t before = allocations;
+    for (size_t i = 0; i < 100; ++i) {
+        if (message.reparse(*messages[i % 2]) != 0) {
+            cerr << "reparse failed" << endl;
+            return 1;
+        }
+    }
+    size_t count = allocations - before;
+
+    if (count != 0) {
+        cerr << "steady state reparse() allocated " << count << " times" << endl;
+        return 1;
+    }
+
+    // reused content must match a fresh parse
+    expected.parse(*messages[1]);
+    if (message != expected) {
+        cerr << "reparse() result differs from parse()" << endl;
+        return 1;
+    }
+
+    cout << "reparse: 0 allocations in steady state" << endl;
+    return 0;
+}
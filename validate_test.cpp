@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022 Sergey Agafonov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+
+#include <iostream>
+#include "jsonobject.h"
+
+using namespace std;
+
+static bool check(const string &text, JsonObject::ValidateError expected, size_t expectedOffset)
+{
+    size_t offset = 0;
+    JsonObject::ValidateError error = JsonObject::validate(text, offset);
+
+    if (error != expected || offset != expectedOffset) {
+        cerr << "validate(";
+        for (unsigned char symbol : text) {
+            if (symbol < 0x20 || symbol >= 0x7F) cerr << "\\x" << hex << int(symbol) << dec;
+            else cerr << symbol;
+        }
+        cerr << ") returned " << error << " at " << offset
+             << ", expected " << expected << " at " << expectedOffset << endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool success = true;
+
+    // well-formed text, offset is the text size
+    success &= check("-0.5e+10", JsonObject::VALID, 8);
+    success &= check(" {\"a\":[{},[],\"\\ud83d\\ude00\",true,false,null]}\n", JsonObject::VALID, 46);
+    success &= check("\"\xE2\x82\xAC\xF0\x9F\x98\x80\xF4\x8F\xBF\xBF\"", JsonObject::VALID, 13);
+
+    // malformed UTF-8: overlong, surrogate, above U+10FFFF, truncated, stray continuation
+    success &= check("[\"\xC0\x80\"]", JsonObject::ERROR_INVALID_UTF8, 2);
+    success &= check("[\"\xE0\x80\x80\"]", JsonObject::ERROR_INVALID_UTF8, 2);
+    success &= check("[\"\xF0\x80\x80\x80\"]", JsonObject::ERROR_INVALID_UTF8, 2);
+    success &= check("[\"\xED\xA0\x80\"]", JsonObject::ERROR_INVALID_UTF8, 2);
+    success &= check("[\"\xF4\x90\x80\x80\"]", JsonObject::ERROR_INVALID_UTF8, 2);
+    success &= check("[\"\xF5\x80\x80\x80\"]", JsonObject::ERROR_INVALID_UTF8, 2);
+    success &= check("[\"\xC2\"]", JsonObject::ERROR_INVALID_UTF8, 2);
+    success &= check("\"\xE2\x82\"", JsonObject::ERROR_INVALID_UTF8, 1);
+    success &= check("\"\x80\"", JsonObject::ERROR_INVALID_UTF8, 1);
+
+    // strings
+    success &= check("[\"\\x\"]", JsonObject::ERROR_INVALID_STRING, 3);
+    success &= check("[\"\\u12\"]", JsonObject::ERROR_INVALID_STRING, 6);
+    success &= check("\"a\x01\"", JsonObject::ERROR_INVALID_STRING, 2);
+
+    // numbers
+    success &= check("[01]", JsonObject::ERROR_UNEXPECTED_SYMBOL, 2);
+    success &= check("[1.]", JsonObject::ERROR_INVALID_NUMBER, 3);
+    success &= check("[1e]", JsonObject::ERROR_INVALID_NUMBER, 3);
+    success &= check("[-]", JsonObject::ERROR_INVALID_NUMBER, 2);
+    success &= check("[.5]", JsonObject::ERROR_UNEXPECTED_SYMBOL, 1);
+
+    // grammar
+    success &= check("[1,]", JsonObject::ERROR_UNEXPECTED_SYMBOL, 3);
+    success &= check("{\"a\":1,}", JsonObject::ERROR_UNEXPECTED_SYMBOL, 7);
+    success &= check("{\"a\" 1}", JsonObject::ERROR_UNEXPECTED_SYMBOL, 5);
+    success &= check("[1]x", JsonObject::ERROR_UNEXPECTED_SYMBOL, 3);
+
+    // truncated text
+    success &= check("", JsonObject::ERROR_UNEXPECTED_END, 0);
+    success &= check("  ", JsonObject::ERROR_UNEXPECTED_END, 2);
+    success &= check("[1", JsonObject::ERROR_UNEXPECTED_END, 2);
+    success &= check("[1,2", JsonObject::ERROR_UNEXPECTED_END, 4);
+    success &= check("[\"ab", JsonObject::ERROR_UNEXPECTED_END, 4);
+    success &= check("{\"a\"", JsonObject::ERROR_UNEXPECTED_END, 4);
+    success &= check("{\"a\":", JsonObject::ERROR_UNEXPECTED_END, 5);
+    success &= check("tru", JsonObject::ERROR_UNEXPECTED_END, 3);
+
+    // nesting limit
+    success &= check(string(4096, '[') + string(4096, ']'), JsonObject::VALID, 8192);
+    success &= check(string(4097, '[') + string(4097, ']'), JsonObject::ERROR_TOO_DEEP, 4096);
+
+    // errors at every position of a word scanned at once
+    for (size_t i = 0; i < 17; ++i) {
+        string prefix = "\"" + string(i, 'a');
+        string suffix = string(20, 'b') + "\"";
+
+        success &= check(prefix + "\xC0\x80" + suffix, JsonObject::ERROR_INVALID_UTF8, i + 1);
+        success &= check(prefix + "\xED\xA0\x80" + suffix, JsonObject::ERROR_INVALID_UTF8, i + 1);
+        success &= check(prefix + "\x1F" + suffix, JsonObject::ERROR_INVALID_STRING, i + 1);
+        success &= check(prefix + "\xE2\x82\xAC" + suffix, JsonObject::VALID, i + 25);
+        success &= check(prefix + "\\\"" + suffix, JsonObject::VALID, i + 24);
+        success &= check(string(i, ' ') + "\n\t\r" + string(i, ' ') + "x", JsonObject::ERROR_UNEXPECTED_SYMBOL, 2 * i + 3);
+    }
+
+    if (!success)
+        return 1;
+
+    cout << "validate: all cases checked" << endl;
+    return 0;
+}